@@ -0,0 +1,251 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLCONTAINER_ADOPTEDBUFFER_H
+#define _LITLCONTAINER_ADOPTEDBUFFER_H
+
+#include "LitlContainer/AlignedBuffer.h"
+
+#include <algorithm> // copy_n
+#include <cstdint> // uintptr_t
+#include <cstdlib> // malloc, free
+#include <functional>
+#include <new> // bad_alloc
+#include <type_traits> // remove_cv
+
+namespace Litl {
+
+/**
+ * @ingroup data_classes
+ * @brief Owning holder of some externally allocated memory, which is released with a custom deleter.
+ * @details
+ * This holder adopts a pointer allocated by some foreign producer (e.g. cfitsio, libtiff, a shared-memory segment),
+ * together with the function which releases it,
+ * such that the data can be used as a `Raster` without copy nor manual lifetime management.
+ *
+ * The alignment of the adopted memory can optionally be declared,
+ * in which case it is checked at construction (see `AlignmentError`)
+ * and exposed as `alignmentReq()` for downstream algorithms, as for `AlignedBuffer`.
+ *
+ * Moving the holder transfers ownership.
+ * Copying it allocates new memory (with the same alignment requirement) and copies the values,
+ * such that the deleter is called exactly once per adopted pointer.
+ *
+ * \par_example
+ * \code
+ * float* data = produce(width * height); // Allocated with malloc()
+ * AdoptedRaster<float> raster({width, height}, data, [](float* p) {
+ *   std::free(p);
+ * });
+ * // data is freed when raster is destroyed
+ * \endcode
+ */
+template <typename T>
+class AdoptedBuffer {
+
+public:
+  /**
+   * @brief The deleter type.
+   */
+  using Deleter = std::function<void(T*)>;
+
+  /// @{
+  /// @group_construction
+
+  /**
+   * @brief Size-based constructor.
+   * @details
+   * Memory is allocated and will be freed by the holder.
+   */
+  explicit AdoptedBuffer(std::size_t size = 0, std::nullptr_t = nullptr, std::size_t align = 0) :
+      m_size(size), m_as(align ? align : alignof(T)), m_data(nullptr), m_deleter() {
+    allocate();
+  }
+
+  /**
+   * @brief Adoption constructor.
+   * @param size The number of elements
+   * @param data The pointer to be adopted
+   * @param deleter The function which releases the pointer
+   * @param align The alignment of the pointer, if known, or 0
+   * @details
+   * If the alignment is not given, it is assumed to be that of `T`.
+   * If the alignment check fails, the pointer is not adopted, i.e. the deleter is not called.
+   */
+  AdoptedBuffer(std::size_t size, T* data, Deleter deleter, std::size_t align = 0) :
+      m_size(size), m_as(align ? align : alignof(T)), m_data(data), m_deleter(std::move(deleter)) {
+    if (m_data) {
+      AlignmentError::mayThrow(m_data, m_as);
+    }
+  }
+
+  /**
+   * @brief Copy constructor.
+   * @details
+   * Memory is allocated, with the same alignment requirement, and values are copied.
+   */
+  AdoptedBuffer(const AdoptedBuffer& other) : m_size(other.m_size), m_as(other.m_as), m_data(nullptr), m_deleter() {
+    allocate();
+    std::copy_n(other.m_data, m_size, const_cast<std::remove_cv_t<T>*>(m_data));
+  }
+
+  /**
+   * @brief Move constructor.
+   * @details
+   * Ownership is transferred, and `other` is left empty.
+   */
+  AdoptedBuffer(AdoptedBuffer&& other) noexcept :
+      m_size(other.m_size), m_as(other.m_as), m_data(other.m_data), m_deleter(std::move(other.m_deleter)) {
+    other.m_deleter = nullptr;
+    other.reset();
+  }
+
+  /**
+   * @brief Copy assignment.
+   */
+  AdoptedBuffer& operator=(const AdoptedBuffer& other) {
+    if (this != &other) {
+      *this = AdoptedBuffer(other);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Move assignment.
+   * @details
+   * The deleter of the current memory, if any, must not throw.
+   */
+  AdoptedBuffer& operator=(AdoptedBuffer&& other) noexcept {
+    if (this != &other) {
+      reset();
+      m_size = other.m_size;
+      m_as = other.m_as;
+      m_data = other.m_data;
+      m_deleter = std::move(other.m_deleter);
+      other.m_deleter = nullptr;
+      other.reset();
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Destructor.
+   * @details
+   * Calls the deleter, if any.
+   */
+  ~AdoptedBuffer() {
+    reset();
+  }
+
+  /// @group_properties
+
+  /**
+   * @brief Get the number of elements.
+   */
+  std::size_t size() const {
+    return m_size;
+  }
+
+  /**
+   * @brief Get the declared alignment requirement.
+   */
+  std::size_t alignmentReq() const {
+    return m_as;
+  }
+
+  /**
+   * @brief Get the actual data alignment, which may be larger than the requirement.
+   */
+  std::size_t alignment() const {
+    return Litl::alignment(m_data);
+  }
+
+  /**
+   * @brief Check whether the holder manages its memory.
+   */
+  bool owns() const {
+    return bool(m_deleter);
+  }
+
+  /// @group_elements
+
+  /**
+   * @brief Access the raw data.
+   */
+  inline const T* data() const {
+    return m_data;
+  }
+
+  /// @group_modifiers
+
+  /**
+   * @brief Release the ownership.
+   * @details
+   * The holder still points to the data, but will not call the deleter anymore.
+   * The deleter is returned, such that the caller can release the memory later.
+   */
+  Deleter release() {
+    Deleter out = std::move(m_deleter);
+    m_deleter = nullptr;
+    return out;
+  }
+
+  /**
+   * @brief Release the memory (if owned) and empty the holder.
+   */
+  void reset() {
+    if (m_deleter && m_data) {
+      m_deleter(m_data);
+    }
+    m_deleter = nullptr;
+    m_size = 0;
+    m_as = alignof(T);
+    m_data = nullptr;
+  }
+
+  /// @}
+
+private:
+  /**
+   * @brief Allocate aligned memory, to be freed by the deleter.
+   */
+  void allocate() {
+    if (m_size == 0) {
+      return;
+    }
+    void* container = std::malloc(sizeof(T) * m_size + m_as - 1);
+    if (not container) {
+      throw std::bad_alloc();
+    }
+    m_data = reinterpret_cast<T*>((std::uintptr_t(container) + (m_as - 1)) & ~(m_as - 1));
+    std::fill_n(const_cast<std::remove_cv_t<T>*>(m_data), m_size, std::remove_cv_t<T>());
+    m_deleter = [container](T*) {
+      std::free(container);
+    };
+  }
+
+  /**
+   * @brief The number of elements.
+   */
+  std::size_t m_size;
+
+  /**
+   * @brief The alignment requirement.
+   */
+  std::size_t m_as;
+
+  /**
+   * @brief The data pointer.
+   */
+  T* m_data;
+
+  /**
+   * @brief The deleter, or an empty function if not owning.
+   */
+  Deleter m_deleter;
+};
+
+} // namespace Litl
+
+#endif
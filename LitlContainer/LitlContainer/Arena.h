@@ -0,0 +1,388 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLCONTAINER_ARENA_H
+#define _LITLCONTAINER_ARENA_H
+
+#include "LitlTypes/TypeUtils.h" // LITL_NON_COPYABLE
+
+#include <algorithm> // max
+#include <cstddef> // max_align_t
+#include <cstdint> // uintptr_t
+#include <memory> // allocator
+#include <new> // operator new
+#include <type_traits> // true_type
+#include <vector>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define LITL_HAS_PMR 1
+#endif
+#endif
+
+namespace Litl {
+
+/**
+ * @ingroup data_classes
+ * @brief Monotonic memory arena, which serves temporaries and releases them all at once.
+ * @details
+ * Memory is carved out of large blocks by bumping a pointer, and individual deallocations are no-ops.
+ * `release()` rewinds the arena without freeing the blocks, such that,
+ * once warmed up, a per-frame arena performs no system allocation at all.
+ *
+ * An arena is made the current arena of the calling thread with an `ArenaScope`.
+ * Then, default-constructed `ArenaAllocator`s, and therefore `ArenaRaster`s and the scratch buffers of the algorithms,
+ * allocate from it; outside of any scope, they fall back to the global heap.
+ * Arenas are not thread-safe and scopes are thread-local,
+ * such that worker threads of a `ThreadPool` keep using the heap.
+ *
+ * Memory served by an arena must not be used after `release()` or destruction of the arena.
+ * Outputs which outlive the frame should therefore be allocated outside of the scope.
+ *
+ * \par_example
+ * \code
+ * Arena arena(64 << 20);
+ * for (const auto& frame : frames) {
+ *   ArenaScope scope(arena);
+ *   ArenaRaster<float> smoothed(frame.shape());
+ *   kernel.correlateTo(extrapolate(frame, 0.F), smoothed); // Scratch buffers are in the arena, too
+ *   process(smoothed);
+ *   arena.release();
+ * }
+ * \endcode
+ */
+class Arena {
+
+public:
+  /// @{
+  /// @group_construction
+
+  /**
+   * @brief Constructor.
+   * @param blockBytes The minimum number of bytes of each block
+   * @details
+   * No memory is allocated until the first allocation.
+   */
+  explicit Arena(std::size_t blockBytes = 1 << 20) :
+      m_blockBytes(std::max<std::size_t>(blockBytes, 1)), m_blocks(), m_current(0), m_used(0), m_allocated(0) {}
+
+  LITL_NON_COPYABLE(Arena)
+  LITL_NON_MOVABLE(Arena)
+
+  /**
+   * @brief Destructor.
+   */
+  ~Arena() {
+    shrink();
+  }
+
+  /**
+   * @brief Get the current arena of the calling thread, or `nullptr` if none.
+   */
+  static Arena* current() {
+    return currentPtr();
+  }
+
+  /// @group_properties
+
+  /**
+   * @brief Get the number of bytes allocated since construction or the last release, including padding.
+   */
+  std::size_t usedBytes() const {
+    return m_allocated;
+  }
+
+  /**
+   * @brief Get the total number of bytes of the blocks.
+   */
+  std::size_t capacity() const {
+    std::size_t out = 0;
+    for (const auto& b : m_blocks) {
+      out += b.size;
+    }
+    return out;
+  }
+
+  /**
+   * @brief Get the number of blocks.
+   */
+  std::size_t blockCount() const {
+    return m_blocks.size();
+  }
+
+  /// @group_modifiers
+
+  /**
+   * @brief Allocate some memory.
+   * @param bytes The number of bytes
+   * @param align The alignment, which must be a power of 2
+   */
+  void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t)) {
+    while (m_current < m_blocks.size()) {
+      auto& block = m_blocks[m_current];
+      const auto address = reinterpret_cast<std::uintptr_t>(block.data) + m_used;
+      const auto padding = (align - address % align) % align;
+      if (m_used + padding + bytes <= block.size) {
+        m_used += padding + bytes;
+        m_allocated += padding + bytes;
+        return reinterpret_cast<void*>(address + padding);
+      }
+      ++m_current;
+      m_used = 0;
+    }
+    const auto size = std::max(m_blockBytes, bytes + align);
+    m_blocks.push_back({static_cast<unsigned char*>(::operator new(size)), size});
+    m_current = m_blocks.size() - 1;
+    return allocate(bytes, align);
+  }
+
+  /**
+   * @brief Release all the allocations at once, keeping the blocks for reuse.
+   */
+  void release() {
+    m_current = 0;
+    m_used = 0;
+    m_allocated = 0;
+  }
+
+  /**
+   * @brief Release all the allocations and free the blocks.
+   */
+  void shrink() {
+    for (const auto& b : m_blocks) {
+      ::operator delete(b.data);
+    }
+    m_blocks.clear();
+    release();
+  }
+
+  /// @}
+
+private:
+  /**
+   * @brief A memory block.
+   */
+  struct Block {
+
+    /**
+     * @brief The data.
+     */
+    unsigned char* data;
+
+    /**
+     * @brief The number of bytes.
+     */
+    std::size_t size;
+  };
+
+  /**
+   * @brief Access the current arena of the calling thread.
+   */
+  static Arena*& currentPtr() {
+    static thread_local Arena* arena = nullptr;
+    return arena;
+  }
+
+  friend class ArenaScope;
+
+  /**
+   * @brief The minimum block size.
+   */
+  std::size_t m_blockBytes;
+
+  /**
+   * @brief The blocks.
+   */
+  std::vector<Block> m_blocks;
+
+  /**
+   * @brief The index of the block being filled.
+   */
+  std::size_t m_current;
+
+  /**
+   * @brief The number of bytes used in the current block.
+   */
+  std::size_t m_used;
+
+  /**
+   * @brief The number of bytes allocated since the last release.
+   */
+  std::size_t m_allocated;
+};
+
+/**
+ * @relates Arena
+ * @brief Make an arena the current arena of the calling thread for the lifetime of the scope.
+ * @details
+ * Scopes can be nested; the previous arena is restored at destruction.
+ */
+class ArenaScope {
+
+public:
+  /**
+   * @brief Constructor.
+   */
+  explicit ArenaScope(Arena& arena) : m_previous(Arena::currentPtr()) {
+    Arena::currentPtr() = &arena;
+  }
+
+  LITL_NON_COPYABLE(ArenaScope)
+  LITL_NON_MOVABLE(ArenaScope)
+
+  /**
+   * @brief Destructor.
+   */
+  ~ArenaScope() {
+    Arena::currentPtr() = m_previous;
+  }
+
+private:
+  /**
+   * @brief The previous arena.
+   */
+  Arena* m_previous;
+};
+
+/**
+ * @relates Arena
+ * @brief Standard allocator which allocates from an arena, or from the heap.
+ * @details
+ * The arena is that of the calling thread at construction, unless explicitly provided.
+ * Without arena, memory is allocated and freed as with `std::allocator`.
+ */
+template <typename T>
+class ArenaAllocator {
+
+public:
+  /**
+   * @brief The value type.
+   */
+  using value_type = T;
+
+  /**
+   * @brief Let containers move the allocator together with the memory.
+   */
+  using propagate_on_container_move_assignment = std::true_type;
+
+  /**
+   * @brief Let containers swap the allocators together with the memory.
+   */
+  using propagate_on_container_swap = std::true_type;
+
+  /**
+   * @brief Constructor.
+   * @param arena The arena, or `nullptr` for the heap
+   */
+  ArenaAllocator(Arena* arena = Arena::current()) noexcept : m_arena(arena) {}
+
+  /**
+   * @brief Rebinding constructor.
+   */
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.arena()) {}
+
+  /**
+   * @brief Get the arena, or `nullptr` for the heap.
+   */
+  Arena* arena() const noexcept {
+    return m_arena;
+  }
+
+  /**
+   * @brief Allocate `n` values.
+   */
+  T* allocate(std::size_t n) {
+    if (m_arena) {
+      return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    return std::allocator<T>().allocate(n);
+  }
+
+  /**
+   * @brief Deallocate `n` values, which is a no-op for arenas.
+   */
+  void deallocate(T* p, std::size_t n) noexcept {
+    if (not m_arena) {
+      std::allocator<T>().deallocate(p, n);
+    }
+  }
+
+  /**
+   * @brief Copy the allocator for the copy of a container, which allocates from the current arena.
+   */
+  ArenaAllocator select_on_container_copy_construction() const {
+    return ArenaAllocator();
+  }
+
+  /**
+   * @brief Check whether two allocators share the same arena.
+   */
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& rhs) const noexcept {
+    return m_arena == rhs.arena();
+  }
+
+  /**
+   * @brief Check whether two allocators have different arenas.
+   */
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& rhs) const noexcept {
+    return m_arena != rhs.arena();
+  }
+
+private:
+  /**
+   * @brief The arena, or `nullptr`.
+   */
+  Arena* m_arena;
+};
+
+/**
+ * @relates Arena
+ * @brief Vector which allocates from the current arena, if any, e.g. for scratch buffers.
+ */
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#ifdef LITL_HAS_PMR
+
+/**
+ * @relates Arena
+ * @brief Adapter of an arena as a `std::pmr::memory_resource`.
+ * @details
+ * This allows arenas to serve `std::pmr` containers and `PmrRaster`s.
+ * Conversely, a `std::pmr::monotonic_buffer_resource` can directly be used with `PmrRaster`.
+ */
+class ArenaResource : public std::pmr::memory_resource {
+
+public:
+  /**
+   * @brief Constructor.
+   */
+  explicit ArenaResource(Arena& arena) : m_arena(arena) {}
+
+private:
+  void* do_allocate(std::size_t bytes, std::size_t align) override {
+    return m_arena.allocate(bytes, align);
+  }
+
+  void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  /**
+   * @brief The arena.
+   */
+  Arena& m_arena;
+};
+
+#endif
+
+} // namespace Litl
+
+#endif
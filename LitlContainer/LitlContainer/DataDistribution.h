@@ -5,6 +5,7 @@
 #ifndef _LITLCONTAINER_DATADISTRIBUTION_H
 #define _LITLCONTAINER_DATADISTRIBUTION_H
 
+#include "LitlContainer/Workspace.h"
 #include "LitlTypes/TypeUtils.h"
 
 #include <algorithm>
@@ -128,12 +129,29 @@ public:
    * @brief Compute the median absolute deviation.
    */
   Floating mad() {
-    std::vector<T> absdev(size());
+    Workspace workspace;
+    return mad(workspace);
+  }
+
+  /**
+   * @brief Compute the median absolute deviation, with a given workspace.
+   * @param workspace The workspace, which provides the buffer of absolute deviations
+   */
+  Floating mad(Workspace& workspace) {
+    const auto n = size();
+    auto* absdev = workspace.template buffer<T>(n);
     const auto m = median();
-    std::transform(m_values.begin(), m_values.end(), absdev.begin(), [=](auto e) {
+    std::transform(m_values.begin(), m_values.end(), absdev, [=](auto e) {
       return std::abs(e - m);
     });
-    return DataDistribution<T>(std::move(absdev)).median();
+    auto* mid = absdev + n / 2;
+    std::nth_element(absdev, mid, absdev + n);
+    if (n % 2 == 1) {
+      return *mid;
+    }
+    const auto upper = *mid;
+    std::nth_element(absdev, mid - 1, mid);
+    return Floating(*(mid - 1) * .5 + upper * .5);
   }
 
   /**
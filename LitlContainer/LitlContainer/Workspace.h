@@ -0,0 +1,154 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLCONTAINER_WORKSPACE_H
+#define _LITLCONTAINER_WORKSPACE_H
+
+#include "LitlContainer/Arena.h"
+
+#include <cstddef> // max_align_t
+#include <type_traits> // is_trivially_destructible
+#include <vector>
+
+namespace Litl {
+
+/**
+ * @ingroup data_classes
+ * @brief Reusable scratch memory for the internal buffers of filters and estimators.
+ * @details
+ * A workspace is a set of numbered slots, each of which is a buffer which grows on demand and never shrinks.
+ * Filters which accept a workspace request their temporary buffers from it instead of allocating them,
+ * such that repeated invocations, e.g. per tile or per stamp, stop allocating once the buffers are large enough.
+ * The contents of the buffers are unspecified when they are handed out.
+ *
+ * A workspace must not be shared between threads.
+ * In parallel loops, `Workspace::local()` provides a workspace per thread, which lives as long as the thread.
+ * Parallel algorithms of the library use it in their tasks,
+ * such that its buffers must not be held by the caller across calls to such algorithms.
+ *
+ * A workspace constructed in the scope of an `Arena` allocates from it, and must therefore not outlive it.
+ *
+ * \par_example
+ * \code
+ * MedianFilter<float> filter(2);
+ * Workspace workspace;
+ * for (const auto& stamp : stamps) {
+ *   filter.applyTo(extrapolate(stamp, 0.F), output, stamp.domain(), workspace); // Allocates once
+ * }
+ * \endcode
+ */
+class Workspace {
+
+public:
+  /// @{
+  /// @group_construction
+
+  /**
+   * @brief Constructor.
+   * @param arena The arena to allocate from, or `nullptr` for the heap
+   * @details
+   * No memory is allocated until the first request.
+   */
+  explicit Workspace(Arena* arena = Arena::current()) : m_arena(arena), m_slots(), m_allocationCount(0) {}
+
+  LITL_NON_COPYABLE(Workspace)
+  LITL_DEFAULT_MOVABLE(Workspace)
+
+  /**
+   * @brief Get the workspace of the calling thread.
+   * @details
+   * The workspace is allocated on the heap, even if the first call happens in the scope of an arena.
+   */
+  static Workspace& local() {
+    static thread_local Workspace workspace(nullptr);
+    return workspace;
+  }
+
+  /// @group_properties
+
+  /**
+   * @brief Get the total number of bytes of the buffers.
+   */
+  std::size_t capacity() const {
+    std::size_t out = 0;
+    for (const auto& s : m_slots) {
+      out += s.size() * sizeof(Unit);
+    }
+    return out;
+  }
+
+  /**
+   * @brief Get the number of buffer allocations since construction.
+   */
+  std::size_t allocationCount() const {
+    return m_allocationCount;
+  }
+
+  /// @group_elements
+
+  /**
+   * @brief Get a buffer of at least `size` values.
+   * @param size The number of values
+   * @param slot The slot index, such that distinct buffers can be used simultaneously
+   * @details
+   * The buffer remains valid until the next request of the same slot with a larger size,
+   * or until the workspace is cleared or destroyed.
+   */
+  template <typename T>
+  T* buffer(std::size_t size, std::size_t slot = 0) {
+    static_assert(std::is_trivially_destructible<T>::value, "Workspace values must be trivially destructible.");
+    static_assert(alignof(T) <= alignof(Unit), "Workspace values must not be over-aligned.");
+    while (slot >= m_slots.size()) {
+      m_slots.emplace_back(ArenaAllocator<Unit>(m_arena));
+    }
+    auto& storage = m_slots[slot];
+    const auto units = (size * sizeof(T) + sizeof(Unit) - 1) / sizeof(Unit);
+    if (storage.size() < units) {
+      storage = Storage(units, ArenaAllocator<Unit>(m_arena));
+      ++m_allocationCount;
+    }
+    return reinterpret_cast<T*>(storage.data());
+  }
+
+  /// @group_modifiers
+
+  /**
+   * @brief Free the buffers.
+   */
+  void clear() {
+    m_slots.clear();
+  }
+
+  /// @}
+
+private:
+  /**
+   * @brief The allocation unit, which is suitably aligned for any scalar type.
+   */
+  using Unit = std::max_align_t;
+
+  /**
+   * @brief The buffer type.
+   */
+  using Storage = std::vector<Unit, ArenaAllocator<Unit>>;
+
+  /**
+   * @brief The arena, or `nullptr`.
+   */
+  Arena* m_arena;
+
+  /**
+   * @brief The buffers.
+   */
+  std::vector<Storage> m_slots;
+
+  /**
+   * @brief The number of buffer allocations.
+   */
+  std::size_t m_allocationCount;
+};
+
+} // namespace Litl
+
+#endif
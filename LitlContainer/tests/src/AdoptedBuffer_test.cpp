@@ -0,0 +1,87 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlContainer/AdoptedBuffer.h"
+
+#include <boost/test/unit_test.hpp>
+#include <type_traits>
+#include <vector>
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(AdoptedBuffer_test)
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(deleter_is_called_once_test) {
+  int count = 0;
+  int* data = new int[3] {1, 2, 3};
+  {
+    AdoptedBuffer<int> buffer(3, data, [&](int* p) {
+      delete[] p;
+      ++count;
+    });
+    BOOST_TEST(buffer.owns());
+    BOOST_TEST(buffer.data() == data);
+    AdoptedBuffer<int> moved(std::move(buffer));
+    BOOST_TEST(not buffer.data());
+    BOOST_TEST(moved.data() == data);
+    const auto copied = moved;
+    BOOST_TEST(copied.data() != data);
+    BOOST_TEST(copied.data()[2] == 3);
+    BOOST_TEST(count == 0);
+  }
+  BOOST_TEST(count == 1);
+}
+
+BOOST_AUTO_TEST_CASE(nothrow_move_test) {
+  static_assert(std::is_nothrow_move_constructible<AdoptedBuffer<int>>::value, "Move constructor");
+  static_assert(std::is_nothrow_move_assignable<AdoptedBuffer<int>>::value, "Move assignment");
+  std::vector<AdoptedBuffer<int>> buffers;
+  buffers.emplace_back(3, new int[3] {1, 2, 3}, [](int* p) {
+    delete[] p;
+  });
+  const auto* data = buffers[0].data();
+  buffers.emplace_back(1, nullptr);
+  BOOST_TEST(buffers[0].data() == data); // Moved, not copied, on reallocation
+}
+
+BOOST_AUTO_TEST_CASE(alignment_test) {
+  AdoptedBuffer<float> owner(10, nullptr, 64);
+  BOOST_TEST(owner.alignmentReq() == 64);
+  BOOST_TEST(owner.alignment() % 64 == 0);
+  const auto copy = owner;
+  BOOST_TEST(copy.alignment() % 64 == 0);
+  int count = 0;
+  auto* misaligned = const_cast<float*>(owner.data()) + 1;
+  BOOST_CHECK_THROW(
+      AdoptedBuffer<float>(
+          9,
+          misaligned,
+          [&](float*) {
+            ++count;
+          },
+          64),
+      AlignmentError);
+  BOOST_TEST(count == 0); // Not adopted
+}
+
+BOOST_AUTO_TEST_CASE(release_test) {
+  int count = 0;
+  AdoptedBuffer<const char> buffer(4, "abc", [&](const char*) {
+    ++count;
+  });
+  auto deleter = buffer.release();
+  BOOST_TEST(not buffer.owns());
+  buffer.reset();
+  BOOST_TEST(count == 0);
+  deleter(nullptr);
+  BOOST_TEST(count == 1);
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlContainer/Arena.h"
+
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(Arena_test)
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(aligned_allocation_test) {
+  Arena arena(1024);
+  BOOST_TEST(arena.blockCount() == 0);
+  arena.allocate(3, 1);
+  auto* p = arena.allocate(100, 64);
+  BOOST_TEST(reinterpret_cast<std::uintptr_t>(p) % 64 == 0);
+  BOOST_TEST(arena.blockCount() == 1);
+  BOOST_TEST(arena.usedBytes() >= 103);
+  auto* large = arena.allocate(4096, 16); // Dedicated block
+  BOOST_TEST(large != nullptr);
+  BOOST_TEST(arena.blockCount() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(release_reuses_blocks_test) {
+  Arena arena(1024);
+  auto* first = arena.allocate(512);
+  arena.allocate(800);
+  BOOST_TEST(arena.blockCount() == 2);
+  const auto capacity = arena.capacity();
+  arena.release();
+  BOOST_TEST(arena.usedBytes() == 0);
+  BOOST_TEST(arena.allocate(512) == first);
+  arena.allocate(800);
+  BOOST_TEST(arena.blockCount() == 2);
+  BOOST_TEST(arena.capacity() == capacity);
+  arena.shrink();
+  BOOST_TEST(arena.blockCount() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(scoped_allocator_test) {
+  Arena arena;
+  BOOST_TEST(Arena::current() == nullptr);
+  ArenaVector<int> heap(10);
+  BOOST_TEST(heap.get_allocator().arena() == nullptr);
+  {
+    ArenaScope scope(arena);
+    BOOST_TEST(Arena::current() == &arena);
+    ArenaVector<int> scratch(100, 1);
+    BOOST_TEST(scratch.get_allocator().arena() == &arena);
+    BOOST_TEST(arena.usedBytes() >= 100 * sizeof(int));
+    {
+      Arena inner;
+      ArenaScope innerScope(inner);
+      BOOST_TEST(Arena::current() == &inner);
+    }
+    BOOST_TEST(Arena::current() == &arena);
+  }
+  BOOST_TEST(Arena::current() == nullptr);
+}
+
+#ifdef LITL_HAS_PMR
+
+BOOST_AUTO_TEST_CASE(pmr_resource_test) {
+  Arena arena;
+  ArenaResource resource(arena);
+  std::pmr::vector<double> values(100, &resource);
+  BOOST_TEST(arena.usedBytes() >= 100 * sizeof(double));
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
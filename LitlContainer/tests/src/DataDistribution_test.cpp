@@ -49,6 +49,15 @@ BOOST_AUTO_TEST_CASE(robust_test) {
   BOOST_TEST(dist.mad() == 1);
 }
 
+BOOST_AUTO_TEST_CASE(mad_workspace_test) {
+  TestContainer<int, 8> data {2, 1, 9, 4, 1, 2, 6, 8};
+  auto dist = data.distribution();
+  Workspace workspace;
+  BOOST_TEST(dist.mad(workspace) == dist.mad());
+  BOOST_TEST(dist.mad(workspace) == 2);
+  BOOST_TEST(workspace.allocationCount() == 1);
+}
+
 BOOST_AUTO_TEST_CASE(histogram_test) {
   TestContainer<int, 10> data;
   data.range();
@@ -0,0 +1,69 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlContainer/Workspace.h"
+
+#include <boost/test/unit_test.hpp>
+#include <complex>
+#include <cstdint>
+#include <thread>
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(Workspace_test)
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(grow_only_test) {
+  Workspace workspace(nullptr);
+  BOOST_TEST(workspace.capacity() == 0);
+  auto* a = workspace.buffer<double>(100);
+  BOOST_TEST(workspace.allocationCount() == 1);
+  BOOST_TEST(workspace.capacity() >= 100 * sizeof(double));
+  BOOST_TEST(workspace.buffer<double>(50) == a);
+  BOOST_TEST(reinterpret_cast<void*>(workspace.buffer<char>(800)) == reinterpret_cast<void*>(a));
+  BOOST_TEST(workspace.allocationCount() == 1);
+  workspace.buffer<double>(1000);
+  BOOST_TEST(workspace.allocationCount() == 2);
+  workspace.clear();
+  BOOST_TEST(workspace.capacity() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(slots_test) {
+  Workspace workspace(nullptr);
+  auto* a = workspace.buffer<int>(10, 0);
+  auto* b = workspace.buffer<std::complex<double>>(10, 2);
+  BOOST_TEST(reinterpret_cast<void*>(a) != reinterpret_cast<void*>(b));
+  BOOST_TEST(reinterpret_cast<std::uintptr_t>(b) % alignof(std::complex<double>) == 0);
+  BOOST_TEST(workspace.buffer<int>(10, 0) == a);
+  BOOST_TEST(workspace.allocationCount() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(arena_workspace_test) {
+  Arena arena;
+  ArenaScope scope(arena);
+  Workspace workspace;
+  workspace.buffer<float>(1000);
+  BOOST_TEST(arena.usedBytes() >= 1000 * sizeof(float));
+  const auto used = arena.usedBytes();
+  Workspace::local().buffer<float>(1000); // Not in the arena
+  BOOST_TEST(arena.usedBytes() == used);
+}
+
+BOOST_AUTO_TEST_CASE(thread_local_test) {
+  auto* main = &Workspace::local();
+  Workspace* other = nullptr;
+  std::thread thread([&]() {
+    other = &Workspace::local();
+  });
+  thread.join();
+  BOOST_TEST(main == &Workspace::local());
+  BOOST_TEST(other != main);
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
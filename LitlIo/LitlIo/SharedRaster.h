@@ -0,0 +1,477 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLIO_SHAREDRASTER_H
+#define _LITLIO_SHAREDRASTER_H
+
+#include "LitlRaster/Raster.h"
+
+#include <algorithm> // any_of, find
+#include <atomic>
+#include <cstdint> // uint32_t, uint64_t
+#include <cstring> // memcpy, strerror
+#include <errno.h>
+#include <fcntl.h> // O_CREAT...
+#include <new> // placement new
+#include <string>
+#include <sys/mman.h> // shm_open, mmap
+#include <sys/stat.h> // fstat
+#include <thread> // yield
+#include <type_traits> // is_trivially_copyable
+#include <unistd.h> // ftruncate, close, sysconf
+
+namespace Litl {
+
+namespace Internal {
+
+/**
+ * @brief The header of a shared memory segment.
+ * @details
+ * The header is followed by the shape, as `dimension` indices, and by the pixel data, at offset `offset`.
+ */
+struct SharedHeader {
+
+  /**
+   * @brief The magic number, which identifies Litl segments, and is stored last by the creator.
+   */
+  std::atomic<std::uint64_t> magic;
+
+  /**
+   * @brief The value type code.
+   */
+  std::uint32_t type;
+
+  /**
+   * @brief The dimension.
+   */
+  std::uint32_t dimension;
+
+  /**
+   * @brief The data alignment, in bytes.
+   */
+  std::uint64_t alignment;
+
+  /**
+   * @brief The data offset from the segment start, in bytes.
+   */
+  std::uint64_t offset;
+
+  /**
+   * @brief The generation counter, odd while the data is being written.
+   */
+  std::atomic<std::uint64_t> generation;
+};
+
+#ifdef __cpp_lib_atomic_is_always_lock_free
+static_assert(
+    std::atomic<std::uint64_t>::is_always_lock_free,
+    "Shared memory requires lock-free atomics."); // Otherwise the lock is process-local
+#endif
+
+/**
+ * @brief Get the address of the shape which follows a header.
+ */
+inline char* sharedShape(SharedHeader* header) {
+  return reinterpret_cast<char*>(header) + sizeof(SharedHeader);
+}
+
+/**
+ * @copydoc sharedShape()
+ */
+inline const char* sharedShape(const SharedHeader* header) {
+  return reinterpret_cast<const char*>(header) + sizeof(SharedHeader);
+}
+
+/**
+ * @brief The magic number of Litl segments.
+ */
+constexpr std::uint64_t sharedMagic = 0x4c49544c53484d31; // "LITLSHM1"
+
+/**
+ * @brief Throw an exception with the last system error.
+ */
+[[noreturn]] inline void throwSystemError(const std::string& message, const std::string& name) {
+  throw Exception(message + ": " + name + " (" + std::strerror(errno) + ")");
+}
+
+} // namespace Internal
+
+/**
+ * @ingroup data_classes
+ * @brief Raster stored in a named POSIX shared memory segment, for zero-copy exchange between processes.
+ * @tparam T The value type, which must be trivially copyable
+ * @tparam N The dimension
+ * @details
+ * A producer creates the segment with a given shape, and consumers attach to it by name.
+ * The segment contains a header (value type, dimension, alignment, generation counter),
+ * the shape and the aligned pixel data.
+ * When attaching, the value type and dimension are checked against `T` and `N`.
+ *
+ * The pixels are accessed without copy as a `PtrRaster` with `raster()`.
+ * For consistent exchanges, the header holds a generation counter which implements a sequence lock:
+ * the (single) producer modifies the data inside `write()`, which increments the counter before and after,
+ * and consumers copy consistent snapshots with `read()` or `snapshot()`,
+ * which retry as long as the data was modified during the copy.
+ * A consumer can poll `generation()` to know if a new frame is available.
+ *
+ * The creator unlinks the segment name at destruction, after which no new process can attach,
+ * while the memory remains valid until the last process detaches.
+ *
+ * \par_example
+ * Producer:
+ * \code
+ * SharedRaster<float> frame("/camera", {2048, 2048});
+ * while (acquiring) {
+ *   frame.write([&](auto& raster) {
+ *     acquire(raster.data());
+ *   });
+ * }
+ * \endcode
+ * Consumer:
+ * \code
+ * SharedRaster<float> frame("/camera");
+ * Raster<float> copy(frame.shape());
+ * auto last = frame.read(copy);
+ * while (processing) {
+ *   if (frame.generation() != last) {
+ *     last = frame.read(copy);
+ *     process(copy);
+ *   }
+ * }
+ * \endcode
+ */
+template <typename T, Index N = 2>
+class SharedRaster {
+
+  static_assert(std::is_trivially_copyable<T>::value, "SharedRaster requires trivially copyable values.");
+
+public:
+  /**
+   * @brief The pixel value type.
+   */
+  using Value = T;
+
+  /**
+   * @brief The dimension.
+   */
+  static constexpr Index Dimension = N;
+
+  /// @{
+  /// @group_construction
+
+  /**
+   * @brief Create a segment.
+   * @param name The segment name, which starts with a slash, e.g. `"/frame"`
+   * @param shape The raster shape
+   * @param align The data alignment, which must be a power of two not greater than the page size
+   * @details
+   * Creation fails if the segment already exists.
+   * Pixels are initialized to zero and the generation is 0.
+   */
+  SharedRaster(const std::string& name, Position<N> shape, std::size_t align = 64) :
+      m_name(name), m_owner(true), m_shape(std::move(shape)), m_bytes(0), m_segment(nullptr), m_data(nullptr) {
+    const auto page = std::size_t(sysconf(_SC_PAGESIZE));
+    if (align == 0 || (align & (align - 1)) || align > page) {
+      throw Exception("Invalid shared memory alignment: " + std::to_string(align));
+    }
+    const auto dimension = m_shape.size();
+    const auto offset = (sizeof(Internal::SharedHeader) + dimension * sizeof(Index) + align - 1) / align * align;
+    m_bytes = offset + shapeSize(m_shape) * sizeof(T);
+    const auto fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      Internal::throwSystemError("Cannot create shared memory segment", m_name);
+    }
+    if (ftruncate(fd, m_bytes) != 0) { // Also fills with zeros
+      close(fd);
+      shm_unlink(m_name.c_str());
+      Internal::throwSystemError("Cannot resize shared memory segment", m_name);
+    }
+    map(fd);
+    auto* header = new (m_segment) Internal::SharedHeader();
+    if (not header->generation.is_lock_free()) {
+      munmap(m_segment, m_bytes);
+      shm_unlink(m_name.c_str());
+      throw Exception("Shared memory requires lock-free atomics: " + m_name);
+    }
+    header->type = TypeTraits<T>::code();
+    header->dimension = std::uint32_t(dimension);
+    header->alignment = align;
+    header->offset = offset;
+    header->generation.store(0);
+    std::memcpy(Internal::sharedShape(header), m_shape.data(), dimension * sizeof(Index));
+    m_data = reinterpret_cast<T*>(static_cast<char*>(m_segment) + offset);
+    header->magic.store(Internal::sharedMagic, std::memory_order_release); // Last, such that attaching fails until then
+  }
+
+  /**
+   * @brief Attach to an existing segment.
+   * @param name The segment name
+   * @details
+   * The value type and dimension of the segment must match `T` and `N`.
+   * The header is validated, such that a corrupted or foreign segment results in an exception
+   * instead of accesses out of the segment.
+   */
+  explicit SharedRaster(const std::string& name) :
+      m_name(name), m_owner(false), m_shape(), m_bytes(0), m_segment(nullptr), m_data(nullptr) {
+    const auto fd = shm_open(m_name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+      Internal::throwSystemError("Cannot open shared memory segment", m_name);
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+      close(fd);
+      Internal::throwSystemError("Cannot stat shared memory segment", m_name);
+    }
+    m_bytes = std::size_t(status.st_size);
+    if (m_bytes < sizeof(Internal::SharedHeader)) {
+      close(fd);
+      throw Exception("Not a raster shared memory segment: " + m_name);
+    }
+    map(fd);
+    try {
+      const auto& h = header();
+      if (h.magic.load(std::memory_order_acquire) != Internal::sharedMagic) {
+        throw Exception("Not a raster shared memory segment: " + m_name);
+      }
+      if (not h.generation.is_lock_free()) {
+        throw Exception("Shared memory requires lock-free atomics: " + m_name);
+      }
+      if (h.type != TypeTraits<T>::code()) {
+        throw Exception("Shared memory value type mismatch: " + m_name);
+      }
+      const auto dimension = Index(h.dimension);
+      if (N != -1 && dimension != N) {
+        throw Exception(
+            "Shared memory dimension mismatch: " + m_name + " (" + std::to_string(dimension) + " vs. " +
+            std::to_string(N) + ")");
+      }
+      const auto shapeEnd = sizeof(Internal::SharedHeader) + dimension * sizeof(Index);
+      if (shapeEnd > m_bytes) {
+        throw Exception("Truncated shared memory segment: " + m_name);
+      }
+      if (h.offset < shapeEnd || h.offset > m_bytes || h.offset % alignof(T) != 0) {
+        throw Exception("Invalid shared memory data offset: " + m_name);
+      }
+      m_shape = Position<N>(dimension);
+      std::memcpy(m_shape.data(), Internal::sharedShape(&h), dimension * sizeof(Index));
+      if (std::any_of(m_shape.begin(), m_shape.end(), [](Index length) {
+            return length < 0;
+          })) {
+        throw Exception("Invalid shared memory shape: " + m_name);
+      }
+      if (std::find(m_shape.begin(), m_shape.end(), 0) == m_shape.end()) {
+        auto capacity = (m_bytes - h.offset) / sizeof(T);
+        for (auto length : m_shape) { // Divide instead of multiplying, which could overflow
+          if (capacity < std::size_t(length)) {
+            throw Exception("Truncated shared memory segment: " + m_name);
+          }
+          capacity /= std::size_t(length);
+        }
+      }
+      m_data = reinterpret_cast<T*>(static_cast<char*>(m_segment) + h.offset);
+    } catch (...) {
+      munmap(m_segment, m_bytes);
+      throw;
+    }
+  }
+
+  LITL_NON_COPYABLE(SharedRaster)
+  LITL_NON_MOVABLE(SharedRaster)
+
+  /**
+   * @brief Destructor.
+   * @details
+   * Detaches from the segment, and unlinks it if this is the creator.
+   */
+  ~SharedRaster() {
+    munmap(m_segment, m_bytes);
+    if (m_owner) {
+      shm_unlink(m_name.c_str());
+    }
+  }
+
+  /**
+   * @brief Remove a segment name, e.g. after a crash of its creator.
+   * @return True if the segment existed
+   */
+  static bool unlink(const std::string& name) {
+    return shm_unlink(name.c_str()) == 0;
+  }
+
+  /// @group_properties
+
+  /**
+   * @brief Get the segment name.
+   */
+  const std::string& name() const {
+    return m_name;
+  }
+
+  /**
+   * @brief Check whether this object created the segment.
+   */
+  bool isOwner() const {
+    return m_owner;
+  }
+
+  /**
+   * @brief Get the raster shape.
+   */
+  const Position<N>& shape() const {
+    return m_shape;
+  }
+
+  /**
+   * @brief Get the data alignment.
+   */
+  std::size_t alignment() const {
+    return header().alignment;
+  }
+
+  /**
+   * @brief Get the current generation.
+   * @details
+   * The generation is incremented twice by each `write()`, and is odd during the write.
+   */
+  std::uint64_t generation() const {
+    return header().generation.load(std::memory_order_acquire);
+  }
+
+  /// @group_elements
+
+  /**
+   * @brief Get a view of the shared data, without synchronization.
+   */
+  PtrRaster<const T, N> raster() const {
+    return PtrRaster<const T, N>(m_shape, m_data);
+  }
+
+  /**
+   * @copydoc raster()
+   */
+  PtrRaster<T, N> raster() {
+    return PtrRaster<T, N>(m_shape, m_data);
+  }
+
+  /// @group_operations
+
+  /**
+   * @brief Modify the shared data, as a new generation.
+   * @param func The function, which takes the view `PtrRaster<T, N>&` as parameter
+   * @return The new generation
+   * @details
+   * There must be a single writer at a time.
+   */
+  template <typename TFunc>
+  std::uint64_t write(TFunc&& func) {
+    auto& counter = header().generation;
+    const auto generation = counter.load(std::memory_order_relaxed);
+    counter.store(generation + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    auto view = raster();
+    func(view);
+    counter.store(generation + 2, std::memory_order_release);
+    return generation + 2;
+  }
+
+  /**
+   * @brief Copy a consistent snapshot of the shared data into a raster.
+   * @param out The destination raster, of shape `shape()`
+   * @return The generation of the snapshot
+   * @details
+   * The copy is retried as long as a `write()` happened during it.
+   */
+  template <typename TRaster>
+  std::uint64_t read(TRaster& out) const {
+    const auto& counter = header().generation;
+    const auto bytes = shapeSize(m_shape) * sizeof(T);
+    while (true) {
+      const auto before = counter.load(std::memory_order_acquire);
+      if (before & 1) { // Write in progress
+        std::this_thread::yield();
+        continue;
+      }
+      std::memcpy(out.data(), m_data, bytes);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (counter.load(std::memory_order_relaxed) == before) {
+        return before;
+      }
+    }
+  }
+
+  /**
+   * @brief Get a consistent snapshot of the shared data.
+   * @see read()
+   */
+  Raster<T, N> snapshot() const {
+    Raster<T, N> out(m_shape);
+    read(out);
+    return out;
+  }
+
+  /// @}
+
+private:
+  /**
+   * @brief Map the whole segment and close the file descriptor.
+   */
+  void map(int fd) {
+    m_segment = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m_segment == MAP_FAILED) {
+      if (m_owner) {
+        shm_unlink(m_name.c_str());
+      }
+      Internal::throwSystemError("Cannot map shared memory segment", m_name);
+    }
+  }
+
+  /**
+   * @brief Get the header.
+   */
+  const Internal::SharedHeader& header() const {
+    return *static_cast<const Internal::SharedHeader*>(m_segment);
+  }
+
+  /**
+   * @copydoc header()
+   */
+  Internal::SharedHeader& header() {
+    return *static_cast<Internal::SharedHeader*>(m_segment);
+  }
+
+  /**
+   * @brief The segment name.
+   */
+  std::string m_name;
+
+  /**
+   * @brief The ownership flag.
+   */
+  bool m_owner;
+
+  /**
+   * @brief The raster shape.
+   */
+  Position<N> m_shape;
+
+  /**
+   * @brief The segment size, in bytes.
+   */
+  std::size_t m_bytes;
+
+  /**
+   * @brief The mapped segment.
+   */
+  void* m_segment;
+
+  /**
+   * @brief The pixel data.
+   */
+  T* m_data;
+};
+
+} // namespace Litl
+
+#endif
@@ -0,0 +1,598 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLIO_TILEDRASTER_H
+#define _LITLIO_TILEDRASTER_H
+
+#include "LitlRaster/Raster.h"
+
+#include <algorithm> // max, min, fill
+#include <fstream>
+#include <list>
+#include <string>
+#include <type_traits> // is_trivially_copyable
+#include <unordered_map>
+
+namespace Litl {
+
+/**
+ * @brief Tile storage as a single binary file.
+ * @details
+ * Tile `i` is stored at offset `i * bytes`.
+ * The file is created if it does not exist, and tiles which were never written,
+ * i.e. which lie past the end of the file, are read as zeros, while other read errors throw.
+ */
+class TileFile {
+
+public:
+  /**
+   * @brief Constructor.
+   * @param path The file path
+   */
+  explicit TileFile(const std::string& path) : m_path(path), m_stream() {
+    m_stream.open(m_path, std::ios::in | std::ios::out | std::ios::binary);
+    if (not m_stream.is_open()) { // Create
+      m_stream.clear();
+      m_stream.open(m_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    }
+    if (not m_stream.is_open()) {
+      throw Exception("Cannot open tile file: " + m_path);
+    }
+  }
+
+  /**
+   * @brief Read a tile.
+   */
+  void read(Index tile, char* data, std::size_t bytes) {
+    m_stream.clear();
+    m_stream.seekg(tile * bytes);
+    m_stream.read(data, bytes);
+    const auto count = m_stream.gcount();
+    if (std::size_t(count) < bytes && (m_stream.bad() || not m_stream.eof())) {
+      throw Exception("Cannot read tile from file: " + m_path);
+    }
+    std::fill(data + count, data + bytes, 0); // Never written
+    m_stream.clear();
+  }
+
+  /**
+   * @brief Write a tile.
+   */
+  void write(Index tile, const char* data, std::size_t bytes) {
+    m_stream.clear();
+    m_stream.seekp(tile * bytes);
+    m_stream.write(data, bytes);
+    if (not m_stream) {
+      throw Exception("Cannot write tile to file: " + m_path);
+    }
+  }
+
+  /**
+   * @brief Flush the file buffers.
+   */
+  void flush() {
+    m_stream.flush();
+  }
+
+private:
+  /**
+   * @brief The file path.
+   */
+  std::string m_path;
+
+  /**
+   * @brief The file stream.
+   */
+  std::fstream m_stream;
+};
+
+/**
+ * @brief Tile storage as one binary file per tile in a directory.
+ * @details
+ * Tile `i` is stored in file `<directory>/<i>.tile`.
+ * The directory must exist, and tiles which were never written, i.e. missing or truncated files,
+ * are read as zeros, while other read errors throw.
+ */
+class TileDirectory {
+
+public:
+  /**
+   * @brief Constructor.
+   * @param path The directory path
+   */
+  explicit TileDirectory(const std::string& path) : m_path(path) {}
+
+  /**
+   * @brief Read a tile.
+   */
+  void read(Index tile, char* data, std::size_t bytes) {
+    std::ifstream stream(filename(tile), std::ios::binary);
+    std::streamsize count = 0;
+    if (stream.is_open()) {
+      stream.read(data, bytes);
+      count = stream.gcount();
+      if (std::size_t(count) < bytes && (stream.bad() || not stream.eof())) {
+        throw Exception("Cannot read tile from file: " + filename(tile));
+      }
+    }
+    std::fill(data + count, data + bytes, 0); // Never written
+  }
+
+  /**
+   * @brief Write a tile.
+   */
+  void write(Index tile, const char* data, std::size_t bytes) {
+    std::ofstream stream(filename(tile), std::ios::binary | std::ios::trunc);
+    stream.write(data, bytes);
+    if (not stream) {
+      throw Exception("Cannot write tile to file: " + filename(tile));
+    }
+  }
+
+  /**
+   * @brief Flush the file buffers.
+   * @details
+   * Files are closed after each write, such that this is a no-op.
+   */
+  void flush() {}
+
+private:
+  /**
+   * @brief Get the file name of a tile.
+   */
+  std::string filename(Index tile) const {
+    return m_path + "/" + std::to_string(tile) + ".tile";
+  }
+
+  /**
+   * @brief The directory path.
+   */
+  std::string m_path;
+};
+
+/**
+ * @ingroup data_classes
+ * @brief Out-of-core raster made of fixed-size tiles stored on disk, behind an LRU cache.
+ * @tparam T The value type, which must be trivially copyable
+ * @tparam N The dimension
+ * @tparam TStore The tile storage, `TileFile` or `TileDirectory`
+ * @details
+ * The raster is partitioned into tiles of shape `tileShape()`
+ * (tiles at the back borders are stored with the same shape, too).
+ * At most `budget()` bytes of tiles are resident in memory (but at least one tile):
+ * tiles are loaded when accessed, and the least recently used tiles are evicted when the budget is exceeded.
+ * Modified tiles are written back when evicted, on `flush()`, and at destruction.
+ *
+ * Tiles are stored as raw data, without header, such that the raster shape and tile shape
+ * must be provided again to reopen some storage.
+ *
+ * Pixels are accessed with `get()` and `set()`, which is slow but convenient.
+ * Positions and regions are checked against the raster domain, and an `OutOfBoundsError` is thrown if needed.
+ * Regions are copied with `read()` and `write()`,
+ * and can be processed in place, without copies, with `readRows()`, `writeRows()` and `forEachTile()`,
+ * which visit the regions tile by tile, such that each tile is loaded at most once.
+ *
+ * \par_example
+ * \code
+ * TiledRaster<float> mosaic({100000, 100000}, {1024, 1024}, "mosaic.bin", 1L << 30); // 1 GB of cache
+ * mosaic.writeRows(region, [](const auto& front, float* row, Index length) {
+ *   std::fill(row, row + length, 0);
+ * });
+ * mosaic.forEachTile([](const Box<2>& box, Raster<float>& tile) {
+ *   tile *= 2;
+ * });
+ * \endcode
+ */
+template <typename T, Index N = 2, typename TStore = TileFile>
+class TiledRaster {
+
+  static_assert(std::is_trivially_copyable<T>::value, "TiledRaster requires trivially copyable values.");
+
+public:
+  /**
+   * @brief The pixel value type.
+   */
+  using Value = T;
+
+  /**
+   * @brief The dimension.
+   */
+  static constexpr Index Dimension = N;
+
+  /**
+   * @brief The tile type.
+   */
+  using Tile = Raster<T, N>;
+
+  /// @{
+  /// @group_construction
+
+  /**
+   * @brief Constructor.
+   * @param shape The raster shape
+   * @param tileShape The tile shape
+   * @param path The storage path
+   * @param budget The maximum number of bytes of resident tiles
+   */
+  TiledRaster(Position<N> shape, Position<N> tileShape, const std::string& path, std::size_t budget) :
+      m_shape(std::move(shape)), m_tileShape(std::move(tileShape)), m_gridShape(m_shape), m_gridStrides(),
+      m_tileBytes(shapeSize(m_tileShape) * sizeof(T)), m_capacity(std::max<std::size_t>(budget / m_tileBytes, 1)),
+      m_store(path), m_lru(), m_tiles(), m_loadCount(0) {
+    for (std::size_t i = 0; i < m_shape.size(); ++i) {
+      m_gridShape[i] = (m_shape[i] + m_tileShape[i] - 1) / m_tileShape[i];
+    }
+    m_gridStrides = shapeStrides(m_gridShape);
+  }
+
+  LITL_NON_COPYABLE(TiledRaster)
+  LITL_NON_MOVABLE(TiledRaster)
+
+  /**
+   * @brief Destructor.
+   * @details
+   * Writes back the modified tiles.
+   */
+  ~TiledRaster() {
+    try {
+      flush();
+    } catch (...) {
+      // Cannot throw from destructor
+    }
+  }
+
+  /// @group_properties
+
+  /**
+   * @brief Get the raster shape.
+   */
+  const Position<N>& shape() const {
+    return m_shape;
+  }
+
+  /**
+   * @brief Get the raster domain.
+   */
+  Box<N> domain() const {
+    return Box<N>::fromShape(Position<N>::zero(), m_shape);
+  }
+
+  /**
+   * @brief Get the tile shape.
+   */
+  const Position<N>& tileShape() const {
+    return m_tileShape;
+  }
+
+  /**
+   * @brief Get the number of tiles along each axis.
+   */
+  const Position<N>& gridShape() const {
+    return m_gridShape;
+  }
+
+  /**
+   * @brief Get the maximum number of bytes of resident tiles.
+   */
+  std::size_t budget() const {
+    return m_capacity * m_tileBytes;
+  }
+
+  /**
+   * @brief Get the number of resident tiles.
+   */
+  std::size_t residentCount() const {
+    return m_tiles.size();
+  }
+
+  /**
+   * @brief Get the number of tile loads since construction, for profiling purpose.
+   */
+  std::size_t loadCount() const {
+    return m_loadCount;
+  }
+
+  /// @group_elements
+
+  /**
+   * @brief Get the value at given position.
+   */
+  T get(const Position<N>& pos) {
+    checkBounds(Box<N>(pos, pos));
+    const auto tilePos = tilePosition(pos);
+    const auto& tile = fetch(tilePos, false);
+    return tile[pos - tileFront(tilePos)];
+  }
+
+  /**
+   * @brief Set the value at given position.
+   */
+  void set(const Position<N>& pos, T value) {
+    checkBounds(Box<N>(pos, pos));
+    const auto tilePos = tilePosition(pos);
+    auto& tile = fetch(tilePos, true);
+    tile[pos - tileFront(tilePos)] = value;
+  }
+
+  /**
+   * @brief Copy a region into a raster.
+   */
+  Raster<T, N> read(const Box<N>& region) {
+    Raster<T, N> out(region.shape());
+    readRows(region, [&](const Position<N>& front, const T* row, Index length) {
+      std::copy(row, row + length, &out[front - region.front()]);
+    });
+    return out;
+  }
+
+  /**
+   * @brief Copy a raster into a region.
+   * @param front The front position of the region
+   * @param raster The raster to be copied
+   */
+  template <typename TRaster>
+  void write(const Position<N>& front, const TRaster& raster) {
+    writeRows(Box<N>::fromShape(front, raster.shape()), [&](const Position<N>& p, T* row, Index length) {
+      const auto* in = &raster[p - front];
+      std::copy(in, in + length, row);
+    });
+  }
+
+  /**
+   * @brief Apply a function to each row span of a region, read-only.
+   * @param region The region
+   * @param func The function, which takes the front position of the span (`const Position<N>&`),
+   * a pointer to its data (`const T*`) and its length (`Index`) as parameters
+   * @details
+   * A span is the part of a row of the region which lies in a given tile.
+   * Spans are visited tile by tile, and in storage order inside each tile.
+   */
+  template <typename TFunc>
+  void readRows(const Box<N>& region, TFunc&& func) {
+    forEachSpan(region, false, std::forward<TFunc>(func));
+  }
+
+  /**
+   * @brief Apply a function to each row span of a region, read-write.
+   * @param region The region
+   * @param func The function, which takes the front position of the span (`const Position<N>&`),
+   * a pointer to its data (`T*`) and its length (`Index`) as parameters
+   * @details
+   * The visited tiles are marked as modified.
+   * @see readRows()
+   */
+  template <typename TFunc>
+  void writeRows(const Box<N>& region, TFunc&& func) {
+    forEachSpan(region, true, std::forward<TFunc>(func));
+  }
+
+  /**
+   * @brief Apply a function to each tile, read-write.
+   * @param func The function, which takes the tile domain in the raster (`const Box<N>&`)
+   * and the tile itself (`Tile&`) as parameters
+   * @details
+   * The tile domain is cropped to the raster domain, while the tile has shape `tileShape()`.
+   * All the tiles are marked as modified.
+   */
+  template <typename TFunc>
+  void forEachTile(TFunc&& func) {
+    for (const auto& tilePos : Box<N>::fromShape(Position<N>::zero(), m_gridShape)) {
+      auto& tile = fetch(tilePos, true);
+      func(tileBox(tilePos), tile);
+    }
+  }
+
+  /// @group_modifiers
+
+  /**
+   * @brief Write back the modified tiles.
+   */
+  void flush() {
+    for (auto& t : m_tiles) {
+      auto& entry = t.second;
+      if (entry.dirty) {
+        save(t.first, entry.tile);
+        entry.dirty = false;
+      }
+    }
+    m_store.flush();
+  }
+
+  /// @}
+
+private:
+  /**
+   * @brief A resident tile.
+   */
+  struct Entry {
+
+    /**
+     * @brief The tile data.
+     */
+    Tile tile;
+
+    /**
+     * @brief The modification flag.
+     */
+    bool dirty;
+
+    /**
+     * @brief The position in the LRU list.
+     */
+    std::list<Index>::iterator lru;
+  };
+
+  /**
+   * @brief Throw an `OutOfBoundsError` if a non-empty region is not contained in the raster domain.
+   */
+  void checkBounds(const Box<N>& region) const {
+    for (std::size_t i = 0; i < m_shape.size(); ++i) {
+      const std::pair<Index, Index> bounds {0, m_shape[i] - 1};
+      const auto name = "Coordinate " + std::to_string(i) + ": ";
+      OutOfBoundsError::mayThrow(name, region.front()[i], bounds);
+      OutOfBoundsError::mayThrow(name, region.back()[i], bounds);
+    }
+  }
+
+  /**
+   * @brief Get the position of the tile which contains a given position.
+   */
+  Position<N> tilePosition(const Position<N>& pos) const {
+    auto out = pos;
+    for (std::size_t i = 0; i < out.size(); ++i) {
+      out[i] /= m_tileShape[i];
+    }
+    return out;
+  }
+
+  /**
+   * @brief Get the front position of a given tile in the raster.
+   */
+  Position<N> tileFront(const Position<N>& tilePos) const {
+    auto out = tilePos;
+    for (std::size_t i = 0; i < out.size(); ++i) {
+      out[i] *= m_tileShape[i];
+    }
+    return out;
+  }
+
+  /**
+   * @brief Get the domain of a given tile in the raster, cropped to the raster domain.
+   */
+  Box<N> tileBox(const Position<N>& tilePos) const {
+    auto front = tileFront(tilePos);
+    auto back = front + m_tileShape - 1;
+    for (std::size_t i = 0; i < back.size(); ++i) {
+      back[i] = std::min(back[i], m_shape[i] - 1);
+    }
+    return {front, back};
+  }
+
+  /**
+   * @brief Get a tile, loading it and evicting the least recently used tile if needed.
+   */
+  Tile& fetch(const Position<N>& tilePos, bool modify) {
+    Index index = 0;
+    for (std::size_t i = 0; i < tilePos.size(); ++i) {
+      index += tilePos[i] * m_gridStrides[i];
+    }
+    auto it = m_tiles.find(index);
+    if (it != m_tiles.end()) { // Hit
+      m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    } else { // Miss
+      if (m_tiles.size() >= m_capacity) {
+        evict();
+      }
+      Tile tile(m_tileShape);
+      m_store.read(index, reinterpret_cast<char*>(tile.data()), m_tileBytes); // Before insertion, because it may throw
+      m_lru.push_front(index);
+      it = m_tiles.emplace(index, Entry {std::move(tile), false, m_lru.begin()}).first;
+      ++m_loadCount;
+    }
+    it->second.dirty |= modify;
+    return it->second.tile;
+  }
+
+  /**
+   * @brief Evict the least recently used tile, writing it back if needed.
+   */
+  void evict() {
+    const auto index = m_lru.back();
+    auto it = m_tiles.find(index);
+    if (it->second.dirty) {
+      save(index, it->second.tile);
+    }
+    m_tiles.erase(it);
+    m_lru.pop_back();
+  }
+
+  /**
+   * @brief Write a tile to the storage.
+   */
+  void save(Index index, const Tile& tile) {
+    m_store.write(index, reinterpret_cast<const char*>(tile.data()), m_tileBytes);
+  }
+
+  /**
+   * @brief Visit the row spans of a region tile by tile.
+   */
+  template <typename TFunc>
+  void forEachSpan(const Box<N>& region, bool modify, TFunc&& func) {
+    for (std::size_t i = 0; i < region.front().size(); ++i) {
+      if (region.back()[i] < region.front()[i]) { // Empty
+        return;
+      }
+    }
+    checkBounds(region);
+    const Box<N> grid(tilePosition(region.front()), tilePosition(region.back()));
+    for (const auto& tilePos : grid) {
+      auto& tile = fetch(tilePos, modify);
+      const auto offset = tileFront(tilePos);
+      const auto box = tileBox(tilePos);
+      auto front = box.front();
+      auto back = box.back();
+      for (std::size_t i = 0; i < front.size(); ++i) {
+        front[i] = std::max(front[i], region.front()[i]);
+        back[i] = std::min(back[i], region.back()[i]);
+      }
+      const auto length = back[0] - front[0] + 1;
+      for (const auto& p : project(Box<N>(front, back))) {
+        func(p, &tile[p - offset], length);
+      }
+    }
+  }
+
+  /**
+   * @brief The raster shape.
+   */
+  Position<N> m_shape;
+
+  /**
+   * @brief The tile shape.
+   */
+  Position<N> m_tileShape;
+
+  /**
+   * @brief The number of tiles along each axis.
+   */
+  Position<N> m_gridShape;
+
+  /**
+   * @brief The strides of the tile grid.
+   */
+  Position<N> m_gridStrides;
+
+  /**
+   * @brief The number of bytes per tile.
+   */
+  std::size_t m_tileBytes;
+
+  /**
+   * @brief The maximum number of resident tiles.
+   */
+  std::size_t m_capacity;
+
+  /**
+   * @brief The tile storage.
+   */
+  TStore m_store;
+
+  /**
+   * @brief The resident tile indices, from most to least recently used.
+   */
+  std::list<Index> m_lru;
+
+  /**
+   * @brief The resident tiles.
+   */
+  std::unordered_map<Index, Entry> m_tiles;
+
+  /**
+   * @brief The number of tile loads.
+   */
+  std::size_t m_loadCount;
+};
+
+} // namespace Litl
+
+#endif
@@ -0,0 +1,134 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlIo/SharedRaster.h"
+
+#include <boost/test/unit_test.hpp>
+#include <fcntl.h> // O_RDWR
+#include <limits>
+#include <sys/mman.h> // shm_open, mmap
+#include <thread>
+#include <unistd.h> // getpid
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(SharedRaster_test)
+
+//-----------------------------------------------------------------------------
+
+std::string segmentName(const std::string& test) {
+  return "/SharedRaster_" + test + "_" + std::to_string(getpid());
+}
+
+BOOST_AUTO_TEST_CASE(create_attach_test) {
+  const auto name = segmentName("create_attach_test");
+  using Shared = SharedRaster<float, 3>;
+  {
+    SharedRaster<float, 3> producer(name, {7, 5, 3}, 128);
+    BOOST_TEST(producer.isOwner());
+    BOOST_TEST(producer.generation() == 0);
+    BOOST_TEST(producer.alignment() == 128);
+    BOOST_TEST(alignment(producer.raster().data()) % 128 == 0);
+    BOOST_CHECK_THROW(Shared(name, {1, 1, 1}), Exception); // Already exists
+    SharedRaster<float, 3> consumer(name);
+    BOOST_TEST(not consumer.isOwner());
+    BOOST_TEST(consumer.shape() == producer.shape());
+    BOOST_TEST(consumer.raster().data() != producer.raster().data()); // Different mappings
+    producer.write([](auto& raster) {
+      raster.range();
+    });
+    BOOST_TEST(consumer.generation() == 2);
+    BOOST_TEST((consumer.raster()[{6, 4, 2}] == 104)); // Zero-copy
+    BOOST_TEST(consumer.snapshot() == producer.raster());
+    SharedRaster<float, -1> dynamic(name);
+    BOOST_TEST(dynamic.shape() == Position<-1>({7, 5, 3}));
+    BOOST_CHECK_THROW(SharedRaster<int> {name}.shape(), Exception); // Type mismatch
+    BOOST_CHECK_THROW(SharedRaster<float> {name}.shape(), Exception); // Dimension mismatch
+  }
+  BOOST_CHECK_THROW(Shared {name}.shape(), Exception); // Unlinked
+  BOOST_TEST(not SharedRaster<float>::unlink(name));
+}
+
+template <typename TFunc>
+void corruptHeader(const std::string& name, TFunc&& func) {
+  const auto fd = shm_open(name.c_str(), O_RDWR, 0600);
+  BOOST_REQUIRE(fd >= 0);
+  const auto bytes = sizeof(Internal::SharedHeader) + sizeof(Index); // Header and 1D shape
+  auto* segment = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  BOOST_REQUIRE(segment != MAP_FAILED);
+  auto* header = static_cast<Internal::SharedHeader*>(segment);
+  func(*header, reinterpret_cast<Index*>(Internal::sharedShape(header)));
+  munmap(segment, bytes);
+}
+
+BOOST_AUTO_TEST_CASE(corrupted_dimension_test) {
+  const auto name = segmentName("corrupted_dimension_test");
+  using Shared = SharedRaster<char, -1>;
+  Shared producer(name, Position<-1>({4}));
+  corruptHeader(name, [](auto& header, auto*) {
+    header.dimension = 1 << 20; // Shape would be read past the segment
+  });
+  BOOST_CHECK_THROW(Shared {name}, Exception);
+}
+
+BOOST_AUTO_TEST_CASE(corrupted_offset_test) {
+  const auto name = segmentName("corrupted_offset_test");
+  using Shared = SharedRaster<int, 1>;
+  Shared producer(name, Position<1>({4}));
+  const auto offset = producer.alignment(); // Past the header and shape
+  for (std::uint64_t corrupted : {std::uint64_t(0), std::uint64_t(sizeof(Internal::SharedHeader)), offset + 1}) {
+    corruptHeader(name, [&](auto& header, auto*) {
+      header.offset = corrupted; // Overlaps the header, or is misaligned
+    });
+    BOOST_CHECK_THROW(Shared {name}, Exception);
+  }
+  corruptHeader(name, [&](auto& header, auto*) {
+    header.offset = offset;
+  });
+  BOOST_CHECK_NO_THROW(Shared {name});
+}
+
+BOOST_AUTO_TEST_CASE(corrupted_shape_test) {
+  const auto name = segmentName("corrupted_shape_test");
+  using Shared = SharedRaster<int, 1>;
+  Shared producer(name, Position<1>({4}));
+  for (Index corrupted : {Index(-4), Index(5), std::numeric_limits<Index>::max() / 2 + 1}) {
+    corruptHeader(name, [&](auto&, auto* shape) {
+      shape[0] = corrupted; // Negative, truncated, or overflowing the size in bytes
+    });
+    BOOST_CHECK_THROW(Shared {name}, Exception);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(consistent_snapshot_test) {
+  const auto name = segmentName("consistent_snapshot_test");
+  SharedRaster<int> producer(name, {64, 64});
+  SharedRaster<int> consumer(name);
+  const int frameCount = 200;
+  std::thread writer([&]() {
+    for (int i = 1; i <= frameCount; ++i) {
+      producer.write([&](auto& raster) {
+        raster.fill(i);
+      });
+    }
+  });
+  Raster<int> copy(consumer.shape());
+  std::uint64_t last = 0;
+  while (last < 2 * frameCount) {
+    last = consumer.read(copy);
+    BOOST_TEST(last % 2 == 0);
+    const auto expected = int(last / 2);
+    BOOST_TEST(std::all_of(copy.begin(), copy.end(), [=](int e) {
+      return e == expected;
+    }));
+  }
+  writer.join();
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
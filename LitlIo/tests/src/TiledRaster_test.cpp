@@ -0,0 +1,129 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlIo/TiledRaster.h"
+
+#include <boost/test/unit_test.hpp>
+#include <cstdio> // remove
+#include <stdlib.h> // mkdtemp
+#include <sys/stat.h> // mkdir
+#include <unistd.h> // rmdir
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(TiledRaster_test)
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(lru_budget_test) {
+  const std::string path = "TiledRaster_lru_budget_test.bin";
+  {
+    TiledRaster<int> raster({100, 80}, {16, 16}, path, 3 * 16 * 16 * sizeof(int));
+    BOOST_TEST(raster.gridShape() == Position<2>({7, 5}));
+    BOOST_TEST(raster.budget() == 3 * 16 * 16 * sizeof(int));
+    raster.set({0, 0}, 1); // Tile 0
+    raster.set({20, 0}, 2); // Tile 1
+    raster.set({40, 0}, 3); // Tile 2
+    BOOST_TEST(raster.loadCount() == 3);
+    BOOST_TEST(raster.get({1, 1}) == 0); // Tile 0 is hit and becomes most recently used
+    BOOST_TEST(raster.loadCount() == 3);
+    raster.set({99, 79}, 4); // Tile 1 is evicted
+    BOOST_TEST(raster.residentCount() == 3);
+    BOOST_TEST(raster.get({0, 0}) == 1);
+    BOOST_TEST(raster.loadCount() == 4);
+    BOOST_TEST(raster.get({20, 0}) == 2); // Reloaded from disk
+    BOOST_TEST(raster.loadCount() == 5);
+  }
+  { // Reopen
+    TiledRaster<int> raster({100, 80}, {16, 16}, path, 1);
+    BOOST_TEST(raster.get({0, 0}) == 1);
+    BOOST_TEST(raster.get({20, 0}) == 2);
+    BOOST_TEST(raster.get({40, 0}) == 3);
+    BOOST_TEST(raster.get({99, 79}) == 4);
+    BOOST_TEST(raster.get({50, 50}) == 0);
+    BOOST_TEST(raster.residentCount() == 1);
+  }
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(region_read_write_test) {
+  const std::string path = "TiledRaster_region_read_write_test.bin";
+  Raster<float, 3> in({23, 17, 9});
+  in.range();
+  TiledRaster<float, 3> raster({40, 30, 20}, {8, 8, 4}, path, 2 * 8 * 8 * 4 * sizeof(float));
+  const Position<3> front {5, 7, 3};
+  raster.write(front, in);
+  const auto out = raster.read(Box<3>::fromShape(front, in.shape()));
+  BOOST_TEST(out == in);
+  BOOST_TEST((raster.get(front) == in[{0, 0, 0}]));
+  BOOST_TEST(raster.get({0, 0, 0}) == 0);
+  Index count = 0;
+  raster.readRows(raster.domain(), [&](const Position<3>&, const float* row, Index length) {
+    for (Index i = 0; i < length; ++i) {
+      count += (row[i] != 0);
+    }
+  });
+  BOOST_TEST(count == in.size() - 1); // in[0] == 0
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(directory_and_tiles_test) {
+  char name[] = "TiledRaster_test_XXXXXX";
+  const std::string dir = mkdtemp(name);
+  {
+    TiledRaster<short, 2, TileDirectory> raster({50, 30}, {10, 10}, dir, 0);
+    raster.forEachTile([](const Box<2>& box, Raster<short>& tile) {
+      for (const auto& p : box) {
+        tile[p - box.front()] = p[0] + p[1];
+      }
+    });
+    BOOST_TEST(raster.residentCount() == 1);
+  }
+  {
+    TiledRaster<short, 2, TileDirectory> raster({50, 30}, {10, 10}, dir, 1 << 20);
+    for (const auto& p : raster.domain()) {
+      BOOST_TEST(raster.get(p) == p[0] + p[1]);
+    }
+    BOOST_TEST(raster.loadCount() == 15);
+  }
+  for (Index i = 0; i < 15; ++i) {
+    std::remove((dir + "/" + std::to_string(i) + ".tile").c_str());
+  }
+  rmdir(dir.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(out_of_bounds_test) {
+  const std::string path = "TiledRaster_out_of_bounds_test.bin";
+  {
+    TiledRaster<int> raster({100, 80}, {16, 16}, path, 1 << 20);
+    BOOST_CHECK_THROW(raster.get({-1, 0}), OutOfBoundsError);
+    BOOST_CHECK_THROW(raster.set({0, 80}, 1), OutOfBoundsError);
+    BOOST_CHECK_THROW(raster.read(Box<2>({90, -2}, {99, 5})), OutOfBoundsError);
+    BOOST_CHECK_THROW(raster.write({95, 0}, Raster<int>({10, 1})), OutOfBoundsError);
+    BOOST_TEST(raster.read(Box<2>::fromShape({10, 10}, {0, 3})).size() == 0);
+    BOOST_TEST(raster.residentCount() == 0);
+  }
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(read_error_test) {
+  char name[] = "TiledRaster_test_XXXXXX";
+  const std::string dir = mkdtemp(name);
+  const auto tile = dir + "/0.tile";
+  BOOST_REQUIRE(mkdir(tile.c_str(), 0700) == 0); // Cannot be read
+  {
+    TiledRaster<short, 2, TileDirectory> raster({50, 30}, {10, 10}, dir, 1 << 20);
+    BOOST_CHECK_THROW(raster.get({0, 0}), Exception);
+    BOOST_TEST(raster.residentCount() == 0);
+    BOOST_TEST(raster.get({10, 0}) == 0); // Never written
+  }
+  rmdir(tile.c_str());
+  rmdir(dir.c_str());
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
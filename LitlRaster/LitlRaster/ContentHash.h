@@ -0,0 +1,338 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLRASTER_CONTENTHASH_H
+#define _LITLRASTER_CONTENTHASH_H
+
+#include "LitlRaster/ParallelFor.h"
+#include "LitlRaster/Raster.h"
+#include "LitlRaster/RegionCopy.h" // clipRegion
+
+#include <algorithm> // min
+#include <cstdint> // uint64_t
+#include <cstring> // memcpy
+#include <initializer_list>
+#include <type_traits> // is_trivially_copyable
+#include <vector>
+
+namespace Litl {
+
+/// @cond INTERNAL
+namespace Internal {
+
+/**
+ * @brief The xxHash64 primes.
+ */
+constexpr std::uint64_t hashPrimes[] = {
+    11400714785074694791ULL,
+    14029467366897019727ULL,
+    1609587929392839161ULL,
+    9650029242287828579ULL,
+    2870177450012600261ULL};
+
+/**
+ * @brief Rotate bits to the left.
+ */
+inline std::uint64_t rotateLeft(std::uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+/**
+ * @brief Read 8 bytes, independently of the alignment.
+ */
+inline std::uint64_t read64(const unsigned char* p) {
+  std::uint64_t out;
+  std::memcpy(&out, p, 8);
+  return out;
+}
+
+/**
+ * @brief Read 4 bytes, independently of the alignment.
+ */
+inline std::uint64_t read32(const unsigned char* p) {
+  std::uint32_t out;
+  std::memcpy(&out, p, 4);
+  return out;
+}
+
+/**
+ * @brief Mix some input into an accumulator.
+ */
+inline std::uint64_t hashRound(std::uint64_t acc, std::uint64_t input) {
+  acc += input * hashPrimes[1];
+  acc = rotateLeft(acc, 31);
+  return acc * hashPrimes[0];
+}
+
+/**
+ * @brief Merge an accumulator into the hash.
+ */
+inline std::uint64_t hashMerge(std::uint64_t hash, std::uint64_t acc) {
+  hash ^= hashRound(0, acc);
+  return hash * hashPrimes[0] + hashPrimes[3];
+}
+
+/**
+ * @brief Check whether all the types of a pack are trivially copyable.
+ */
+template <typename... Ts>
+constexpr bool allTriviallyCopyable() {
+  bool out = true;
+  (void)std::initializer_list<bool> {(out = out && std::is_trivially_copyable<Ts>::value)...};
+  return out;
+}
+
+} // namespace Internal
+/// @endcond
+
+/**
+ * @brief Compute the 64-bit non-cryptographic hash of a byte sequence.
+ * @param data The bytes
+ * @param size The number of bytes
+ * @param seed The seed
+ * @details
+ * This is the xxHash64 algorithm, which processes 32 bytes per iteration in four independent lanes.
+ * It is portable across platforms of the same endianness.
+ */
+inline std::uint64_t hashBytes(const void* data, std::size_t size, std::uint64_t seed = 0) {
+  using namespace Internal;
+  const auto* p = static_cast<const unsigned char*>(data);
+  const auto* end = p + size;
+  std::uint64_t hash;
+  if (size >= 32) {
+    std::uint64_t v1 = seed + hashPrimes[0] + hashPrimes[1];
+    std::uint64_t v2 = seed + hashPrimes[1];
+    std::uint64_t v3 = seed;
+    std::uint64_t v4 = seed - hashPrimes[0];
+    const auto* limit = end - 32;
+    do {
+      v1 = hashRound(v1, read64(p));
+      v2 = hashRound(v2, read64(p + 8));
+      v3 = hashRound(v3, read64(p + 16));
+      v4 = hashRound(v4, read64(p + 24));
+      p += 32;
+    } while (p <= limit);
+    hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+    hash = hashMerge(hash, v1);
+    hash = hashMerge(hash, v2);
+    hash = hashMerge(hash, v3);
+    hash = hashMerge(hash, v4);
+  } else {
+    hash = seed + hashPrimes[4];
+  }
+  hash += size;
+  for (; p + 8 <= end; p += 8) {
+    hash ^= hashRound(0, read64(p));
+    hash = rotateLeft(hash, 27) * hashPrimes[0] + hashPrimes[3];
+  }
+  if (p + 4 <= end) {
+    hash ^= read32(p) * hashPrimes[0];
+    hash = rotateLeft(hash, 23) * hashPrimes[1] + hashPrimes[2];
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    hash ^= (*p) * hashPrimes[4];
+    hash = rotateLeft(hash, 11) * hashPrimes[0];
+  }
+  hash ^= hash >> 33;
+  hash *= hashPrimes[1];
+  hash ^= hash >> 29;
+  hash *= hashPrimes[2];
+  hash ^= hash >> 32;
+  return hash;
+}
+
+/**
+ * @brief Compute the hash of trivially copyable values, e.g. the parameters of some operation.
+ */
+template <typename... Ts>
+std::uint64_t hashValues(const Ts&... values) {
+  static_assert(Internal::allTriviallyCopyable<Ts...>(), "Values must be trivially copyable.");
+  std::uint64_t hash = 0;
+  (void)std::initializer_list<int> {(hash = hashBytes(&values, sizeof(values), hash), 0)...};
+  return hash;
+}
+
+/**
+ * @ingroup data_classes
+ * @brief Incremental content hash of a raster, which covers the value type, shape and pixel values.
+ * @details
+ * The pixel data is split into chunks of `chunkBytes` bytes which are hashed independently, in parallel,
+ * and the hash is that of the type, shape and chunk hashes.
+ * The result is thus independent of the number of threads.
+ * When a region of the raster is modified, the hash is updated with `update()`,
+ * which rehashes only the chunks which intersect the region.
+ *
+ * Values are hashed as bytes, such that, e.g., 0 and -0 floating point values are different.
+ * The hash is not cryptographic, and is intended for memoization and deduplication only.
+ *
+ * \par_example
+ * \code
+ * ContentHash hash(frame);
+ * frame[{10, 20}] = 0;
+ * hash.update(frame, Box<2>({10, 20}, {10, 20}));
+ * if (hash.value() == reference) {
+ *   ...
+ * }
+ * \endcode
+ * @see MemoCache
+ */
+class ContentHash {
+
+public:
+  /**
+   * @brief The number of bytes per chunk.
+   */
+  static constexpr std::size_t chunkBytes = 1 << 16;
+
+  /// @{
+  /// @group_construction
+
+  /**
+   * @brief Hash a raster.
+   * @param raster The raster
+   * @param pool The thread pool
+   */
+  template <typename TRaster>
+  explicit ContentHash(const TRaster& raster, ThreadPool& pool = ThreadPool::global()) :
+      m_header(0), m_chunks(), m_value(0) {
+    m_header = header(raster);
+    const auto bytes = raster.size() * sizeof(typename TRaster::Value);
+    m_chunks.resize((bytes + chunkBytes - 1) / chunkBytes);
+    const auto* data = reinterpret_cast<const unsigned char*>(raster.data());
+    pool.run(m_chunks.size(), [&](std::size_t i) {
+      m_chunks[i] = hashChunk(data, bytes, i);
+    });
+    combine();
+  }
+
+  /// @group_properties
+
+  /**
+   * @brief Get the hash value.
+   */
+  std::uint64_t value() const {
+    return m_value;
+  }
+
+  /**
+   * @brief Get the number of chunks.
+   */
+  std::size_t chunkCount() const {
+    return m_chunks.size();
+  }
+
+  /// @group_operations
+
+  /**
+   * @brief Check whether two hashes are equal.
+   */
+  bool operator==(const ContentHash& rhs) const {
+    return m_value == rhs.m_value;
+  }
+
+  /**
+   * @brief Check whether two hashes are different.
+   */
+  bool operator!=(const ContentHash& rhs) const {
+    return m_value != rhs.m_value;
+  }
+
+  /// @group_modifiers
+
+  /**
+   * @brief Update the hash after a region of the raster was modified.
+   * @param raster The modified raster, whose type and shape must be unchanged
+   * @param region The modified region, which is clipped to the raster domain
+   * @param pool The thread pool
+   */
+  template <typename TRaster>
+  void update(const TRaster& raster, Box<TRaster::Dimension> region, ThreadPool& pool = ThreadPool::global()) {
+    using T = typename TRaster::Value;
+    if (header(raster) != m_header) {
+      throw Exception("Cannot update hash: value type or shape changed.");
+    }
+    auto front = region.front();
+    if (not Internal::clipRegion(raster.shape(), region, raster.shape(), front)) {
+      return;
+    }
+    const auto bytes = raster.size() * sizeof(T);
+    std::vector<bool> dirty(m_chunks.size(), false);
+    const auto length = region.length(0);
+    for (const auto& p : project(region)) {
+      const auto first = std::size_t(raster.index(p)) * sizeof(T);
+      const auto last = first + length * sizeof(T) - 1;
+      for (auto c = first / chunkBytes; c <= last / chunkBytes; ++c) {
+        dirty[c] = true;
+      }
+    }
+    std::vector<std::size_t> chunks;
+    for (std::size_t c = 0; c < dirty.size(); ++c) {
+      if (dirty[c]) {
+        chunks.push_back(c);
+      }
+    }
+    const auto* data = reinterpret_cast<const unsigned char*>(raster.data());
+    pool.run(chunks.size(), [&](std::size_t i) {
+      m_chunks[chunks[i]] = hashChunk(data, bytes, chunks[i]);
+    });
+    combine();
+  }
+
+  /// @}
+
+private:
+  /**
+   * @brief Hash the value type and shape.
+   */
+  template <typename TRaster>
+  static std::uint64_t header(const TRaster& raster) {
+    const auto code = TypeTraits<std::remove_const_t<typename TRaster::Value>>::code();
+    const auto& shape = raster.shape();
+    return hashBytes(shape.data(), shape.size() * sizeof(Index), code);
+  }
+
+  /**
+   * @brief Hash a chunk.
+   */
+  static std::uint64_t hashChunk(const unsigned char* data, std::size_t bytes, std::size_t chunk) {
+    const auto begin = chunk * chunkBytes;
+    return hashBytes(data + begin, std::min(chunkBytes, bytes - begin));
+  }
+
+  /**
+   * @brief Combine the header and chunk hashes.
+   */
+  void combine() {
+    m_value = hashBytes(m_chunks.data(), m_chunks.size() * sizeof(std::uint64_t), m_header);
+  }
+
+  /**
+   * @brief The hash of the value type and shape.
+   */
+  std::uint64_t m_header;
+
+  /**
+   * @brief The chunk hashes.
+   */
+  std::vector<std::uint64_t> m_chunks;
+
+  /**
+   * @brief The hash value.
+   */
+  std::uint64_t m_value;
+};
+
+/**
+ * @relates ContentHash
+ * @brief Compute the content hash of a raster.
+ */
+template <typename TRaster>
+std::uint64_t contentHash(const TRaster& raster, ThreadPool& pool = ThreadPool::global()) {
+  return ContentHash(raster, pool).value();
+}
+
+} // namespace Litl
+
+#endif
@@ -0,0 +1,258 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLRASTER_ENUMERATION_H
+#define _LITLRASTER_ENUMERATION_H
+
+#include "LitlRaster/Box.h"
+
+#include <cstddef> // ptrdiff_t
+#include <iterator> // forward_iterator_tag
+
+namespace Litl {
+
+/**
+ * @ingroup data_classes
+ * @brief Iterable over the positions of a box and the associated raw indices in some raster.
+ * @details
+ * Iterating over an enumeration yields elements with `position` and `index` members,
+ * in storage order.
+ * Both are updated incrementally, without multiplication,
+ * which makes this the cheapest way to loop over a region when both the position and the index are needed.
+ *
+ * Enumerations are generally obtained with `Raster::enumerate()`, e.g.:
+ * \code
+ * for (const auto& e : raster.enumerate(box)) {
+ *   out[e.index] = f(e.position, raster[e.index]);
+ * }
+ * \endcode
+ *
+ * The box is not required to lie inside the raster domain,
+ * but the indices of the positions outside the domain are meaningless.
+ */
+template <Index N = 2>
+class Enumeration {
+
+public:
+  /**
+   * @brief The enumeration element.
+   */
+  struct Element {
+
+    /**
+     * @brief The current position.
+     */
+    Position<N> position;
+
+    /**
+     * @brief The raw index of the current position.
+     */
+    Index index;
+  };
+
+  /**
+   * @brief The enumeration iterator.
+   */
+  class Iterator {
+
+  public:
+    /**
+     * @brief The iterator category.
+     */
+    using iterator_category = std::forward_iterator_tag;
+
+    /**
+     * @brief The element type.
+     */
+    using value_type = Element;
+
+    /**
+     * @brief The distance type.
+     */
+    using difference_type = std::ptrdiff_t;
+
+    /**
+     * @brief The element pointer type.
+     */
+    using pointer = const Element*;
+
+    /**
+     * @brief The element reference type.
+     */
+    using reference = const Element&;
+
+    /**
+     * @brief Constructor.
+     */
+    Iterator(const Enumeration& enumeration, Position<N> position, Index index) :
+        m_enumeration(&enumeration), m_current {std::move(position), index} {}
+
+    /**
+     * @brief Dereference operator.
+     */
+    const Element& operator*() const {
+      return m_current;
+    }
+
+    /**
+     * @brief Arrow operator.
+     */
+    const Element* operator->() const {
+      return &m_current;
+    }
+
+    /**
+     * @brief Increment operator.
+     * @details
+     * The position is incremented along the first axis,
+     * and is wrapped to the next row, plane... when the box back is reached.
+     */
+    Iterator& operator++() {
+      const auto& front = m_enumeration->m_box.front();
+      const auto& back = m_enumeration->m_box.back();
+      const auto& strides = m_enumeration->m_strides;
+      const auto& wraps = m_enumeration->m_wraps;
+      auto& position = m_current.position;
+      auto& index = m_current.index;
+      ++position[0];
+      index += strides[0];
+      const auto last = position.size() - 1;
+      for (std::size_t i = 0; i < last && position[i] > back[i]; ++i) {
+        position[i] = front[i];
+        index -= wraps[i];
+        ++position[i + 1];
+        index += strides[i + 1];
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Post-increment operator.
+     */
+    Iterator operator++(int) {
+      auto out = *this;
+      ++*this;
+      return out;
+    }
+
+    /**
+     * @brief Equality operator.
+     * @details
+     * Positions are compared instead of indices,
+     * which are not unique if the box is not included in the raster domain.
+     */
+    bool operator==(const Iterator& rhs) const {
+      return m_current.position == rhs.m_current.position;
+    }
+
+    /**
+     * @brief Non-equality operator.
+     */
+    bool operator!=(const Iterator& rhs) const {
+      return not(*this == rhs);
+    }
+
+  private:
+    /**
+     * @brief The parent enumeration.
+     */
+    const Enumeration* m_enumeration;
+
+    /**
+     * @brief The current element.
+     */
+    Element m_current;
+  };
+
+  /**
+   * @brief Constructor.
+   * @param box The box to be enumerated
+   * @param strides The raster strides
+   */
+  Enumeration(Box<N> box, Position<N> strides) :
+      m_box(std::move(box)), m_strides(std::move(strides)), m_wraps(m_strides), m_front(0), m_end(0),
+      m_endPosition(m_box.front()) {
+    const auto dim = m_strides.size();
+    for (std::size_t i = 0; i < dim; ++i) {
+      m_wraps[i] *= m_box.length(i);
+      m_front += m_box.front()[i] * m_strides[i];
+    }
+    if (m_box.size() > 0) {
+      m_end = m_front + m_wraps[dim - 1];
+      m_endPosition[dim - 1] = m_box.back()[dim - 1] + 1;
+    } else {
+      m_end = m_front;
+    }
+  }
+
+  /**
+   * @brief Get the box.
+   */
+  const Box<N>& box() const {
+    return m_box;
+  }
+
+  /**
+   * @brief Get the strides.
+   */
+  const Position<N>& strides() const {
+    return m_strides;
+  }
+
+  /**
+   * @brief Get the number of elements.
+   */
+  Index size() const {
+    return m_box.size();
+  }
+
+  /**
+   * @brief Iterator to the first element.
+   */
+  Iterator begin() const {
+    return Iterator(*this, m_box.front(), m_front);
+  }
+
+  /**
+   * @brief End iterator.
+   */
+  Iterator end() const {
+    return Iterator(*this, m_endPosition, m_end);
+  }
+
+private:
+  /**
+   * @brief The box.
+   */
+  Box<N> m_box;
+
+  /**
+   * @brief The raster strides.
+   */
+  Position<N> m_strides;
+
+  /**
+   * @brief The index jumps to wrap around each axis.
+   */
+  Position<N> m_wraps;
+
+  /**
+   * @brief The index of the box front.
+   */
+  Index m_front;
+
+  /**
+   * @brief The index past the last element.
+   */
+  Index m_end;
+
+  /**
+   * @brief The position past the last element, i.e. where the increment operator wraps the last element to.
+   */
+  Position<N> m_endPosition;
+};
+
+} // namespace Litl
+
+#endif
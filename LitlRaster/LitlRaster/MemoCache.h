@@ -0,0 +1,320 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLRASTER_MEMOCACHE_H
+#define _LITLRASTER_MEMOCACHE_H
+
+#include "LitlRaster/ContentHash.h"
+#include "LitlTypes/TypeUtils.h" // templateVoid
+
+#include <cstdint> // uint64_t
+#include <functional>
+#include <list>
+#include <memory> // shared_ptr
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Litl {
+
+/// @cond INTERNAL
+namespace Internal {
+
+/**
+ * @brief Estimate the number of bytes of a value: `sizeof` in general.
+ */
+template <typename T, typename = void>
+struct MemoSize {
+  static std::size_t bytes(const T&) {
+    return sizeof(T);
+  }
+};
+
+/**
+ * @brief Estimate the number of bytes of a value: the data size for contiguous containers.
+ */
+template <typename T>
+struct MemoSize<T, templateVoid<decltype(std::declval<const T&>().data()), decltype(std::declval<const T&>().size())>> {
+  static std::size_t bytes(const T& value) {
+    return sizeof(T) + value.size() * sizeof(*value.data());
+  }
+};
+
+} // namespace Internal
+/// @endcond
+
+/**
+ * @ingroup data_classes
+ * @brief Memoization cache of operation results, keyed by operation, parameters and input hash, with a byte budget.
+ * @tparam TValue The result type
+ * @details
+ * Results are identified by the name of the operation, the hash of its parameters (e.g. with `hashValues()`)
+ * and the content hash of its input (see `ContentHash`).
+ * When the total size of the resident results exceeds the budget, the least recently used ones are evicted.
+ * The size of a result is estimated as its data size for containers like rasters, and `sizeof` otherwise,
+ * unless a sizer function is provided.
+ *
+ * Results are shared as pointers to constant values, which remain valid after eviction.
+ * The cache can be accessed concurrently; in case of concurrent misses of the same key,
+ * the result may be computed more than once but a single one is kept.
+ *
+ * \par_example
+ * \code
+ * MemoCache<Raster<float>> cache(1L << 30); // 1 GB
+ * const auto smoothed = cache.get("gaussian", hashValues(sigma), contentHash(image), [&]() {
+ *   return gaussianFilter(image, sigma);
+ * });
+ * \endcode
+ */
+template <typename TValue>
+class MemoCache {
+
+public:
+  /**
+   * @brief The result type.
+   */
+  using Value = TValue;
+
+  /**
+   * @brief The function which estimates the number of bytes of a result.
+   */
+  using Sizer = std::function<std::size_t(const TValue&)>;
+
+  /// @{
+  /// @group_construction
+
+  /**
+   * @brief Constructor.
+   * @param budget The maximum number of bytes of resident results
+   * @param sizer The function which estimates the size of a result, or `nullptr` for the default estimation
+   */
+  explicit MemoCache(std::size_t budget, Sizer sizer = nullptr) :
+      m_budget(budget), m_sizer(std::move(sizer)), m_resident(0), m_hits(0), m_misses(0), m_lru(), m_entries(),
+      m_mutex() {}
+
+  LITL_NON_COPYABLE(MemoCache)
+  LITL_NON_MOVABLE(MemoCache)
+
+  /// @group_properties
+
+  /**
+   * @brief Get the budget, in bytes.
+   */
+  std::size_t budget() const {
+    return m_budget;
+  }
+
+  /**
+   * @brief Get the number of bytes of the resident results.
+   */
+  std::size_t residentBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_resident;
+  }
+
+  /**
+   * @brief Get the number of resident results.
+   */
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+  }
+
+  /**
+   * @brief Get the number of calls which did not compute the result.
+   */
+  std::size_t hitCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+  }
+
+  /**
+   * @brief Get the number of calls which computed the result.
+   */
+  std::size_t missCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+  }
+
+  /// @group_operations
+
+  /**
+   * @brief Get a result, computing it if needed.
+   * @param operation The operation name
+   * @param parameters The hash of the parameters
+   * @param input The content hash of the input
+   * @param func The function which computes the result, without parameter
+   * @details
+   * A result larger than the budget is returned but not cached.
+   */
+  template <typename TFunc>
+  std::shared_ptr<const TValue>
+  get(const std::string& operation, std::uint64_t parameters, std::uint64_t input, TFunc&& func) {
+    const Key key {operation, parameters, input};
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto it = m_entries.find(key);
+      if (it != m_entries.end()) { // Hit
+        ++m_hits;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        return it->second.value;
+      }
+      ++m_misses;
+    }
+    auto value = std::make_shared<const TValue>(func()); // Computed without lock
+    const auto bytes = m_sizer ? m_sizer(*value) : Internal::MemoSize<TValue>::bytes(*value);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) { // Concurrently computed
+      return it->second.value;
+    }
+    if (bytes > m_budget) {
+      return value;
+    }
+    while (m_resident + bytes > m_budget) {
+      evict();
+    }
+    m_lru.push_front(key);
+    m_entries.emplace(key, Entry {value, bytes, m_lru.begin()});
+    m_resident += bytes;
+    return value;
+  }
+
+  /**
+   * @brief Check whether a result is resident, without modifying the recency.
+   */
+  bool contains(const std::string& operation, std::uint64_t parameters, std::uint64_t input) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.count({operation, parameters, input});
+  }
+
+  /// @group_modifiers
+
+  /**
+   * @brief Evict all the results and reset the counters.
+   */
+  void clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_lru.clear();
+    m_resident = 0;
+    m_hits = 0;
+    m_misses = 0;
+  }
+
+  /// @}
+
+private:
+  /**
+   * @brief The result key.
+   */
+  struct Key {
+
+    /**
+     * @brief The operation name.
+     */
+    std::string operation;
+
+    /**
+     * @brief The hash of the parameters.
+     */
+    std::uint64_t parameters;
+
+    /**
+     * @brief The content hash of the input.
+     */
+    std::uint64_t input;
+
+    /**
+     * @brief Check whether two keys are equal.
+     */
+    bool operator==(const Key& rhs) const {
+      return parameters == rhs.parameters && input == rhs.input && operation == rhs.operation;
+    }
+  };
+
+  /**
+   * @brief The key hash function.
+   */
+  struct KeyHash {
+    std::size_t operator()(const Key& key) const {
+      return hashBytes(key.operation.data(), key.operation.size(), hashValues(key.parameters, key.input));
+    }
+  };
+
+  /**
+   * @brief A resident result.
+   */
+  struct Entry {
+
+    /**
+     * @brief The result.
+     */
+    std::shared_ptr<const TValue> value;
+
+    /**
+     * @brief The estimated number of bytes.
+     */
+    std::size_t bytes;
+
+    /**
+     * @brief The position in the LRU list.
+     */
+    typename std::list<Key>::iterator lru;
+  };
+
+  /**
+   * @brief Evict the least recently used result.
+   */
+  void evict() {
+    auto it = m_entries.find(m_lru.back());
+    m_resident -= it->second.bytes;
+    m_entries.erase(it);
+    m_lru.pop_back();
+  }
+
+  /**
+   * @brief The budget.
+   */
+  std::size_t m_budget;
+
+  /**
+   * @brief The size estimator.
+   */
+  Sizer m_sizer;
+
+  /**
+   * @brief The number of bytes of the resident results.
+   */
+  std::size_t m_resident;
+
+  /**
+   * @brief The number of hits.
+   */
+  std::size_t m_hits;
+
+  /**
+   * @brief The number of misses.
+   */
+  std::size_t m_misses;
+
+  /**
+   * @brief The resident keys, from most to least recently used.
+   */
+  std::list<Key> m_lru;
+
+  /**
+   * @brief The resident results.
+   */
+  std::unordered_map<Key, Entry, KeyHash> m_entries;
+
+  /**
+   * @brief The mutex.
+   */
+  mutable std::mutex m_mutex;
+};
+
+} // namespace Litl
+
+#endif
@@ -0,0 +1,172 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLRASTER_PARALLELFOR_H
+#define _LITLRASTER_PARALLELFOR_H
+
+#include "LitlRaster/Box.h"
+#include "LitlRaster/ThreadPool.h"
+
+#include <vector>
+
+namespace Litl {
+
+/**
+ * @brief The default maximum number of positions per grain in parallel loops.
+ */
+constexpr Index defaultGrainSize = 1 << 14;
+
+/// @cond INTERNAL
+namespace Internal {
+
+/**
+ * @brief Recursively bisect a box until grain size is reached.
+ */
+template <Index N>
+void bisect(const Box<N>& box, Index grainSize, Index firstAxis, std::vector<Box<N>>& grains) {
+  if (box.size() <= grainSize) {
+    grains.push_back(box);
+    return;
+  }
+  Index axis = box.dimension() - 1;
+  while (axis >= firstAxis && box.length(axis) == 1) {
+    --axis;
+  }
+  if (axis < firstAxis) { // Cannot be split anymore
+    grains.push_back(box);
+    return;
+  }
+  auto front = box.front();
+  auto back = box.back();
+  const auto middle = front[axis] + box.length(axis) / 2;
+  back[axis] = middle - 1;
+  bisect(Box<N>(box.front(), back), grainSize, firstAxis, grains);
+  front[axis] = middle;
+  bisect(Box<N>(front, box.back()), grainSize, firstAxis, grains);
+}
+
+} // namespace Internal
+/// @endcond
+
+/**
+ * @relates Box
+ * @brief Partition a box into grains for parallel processing.
+ * @param box The box to be partitioned
+ * @param grainSize The maximum number of positions per grain
+ * @param firstAxis The first axis which can be split, e.g. 1 to preserve whole rows
+ * @details
+ * The box is recursively bisected along its outermost axis of length greater than 1,
+ * until the grains contain at most `grainSize` positions,
+ * or cannot be split anymore (in which case they may be larger).
+ * Grains are returned in storage order.
+ *
+ * The partitioning only depends on the box and parameters,
+ * and not on the number of threads or on scheduling,
+ * which makes parallel reductions over grains reproducible.
+ */
+template <Index N>
+std::vector<Box<N>> partition(const Box<N>& box, Index grainSize = defaultGrainSize, Index firstAxis = 0) {
+  std::vector<Box<N>> grains;
+  if (box.size() > 0) {
+    Internal::bisect(box, std::max(grainSize, Index(1)), firstAxis, grains);
+  }
+  return grains;
+}
+
+/**
+ * @relates Box
+ * @brief Apply a function to each grain of a box in parallel.
+ * @param box The box to be partitioned
+ * @param func The function, which takes a `const Box<N>&` as parameter
+ * @param grainSize The maximum number of positions per grain
+ * @param pool The thread pool
+ * @details
+ * This is the building block of the other parallel loops:
+ * it allows the function to set up some state once per grain.
+ * @see `partition()`
+ */
+template <Index N, typename TFunc>
+void parallelForEachGrain(
+    const Box<N>& box,
+    TFunc&& func,
+    Index grainSize = defaultGrainSize,
+    ThreadPool& pool = ThreadPool::global()) {
+  const auto grains = partition(box, grainSize);
+  pool.run(grains.size(), [&](std::size_t i) {
+    func(grains[i]);
+  });
+}
+
+/**
+ * @relates Box
+ * @brief Apply a function to each position of a box in parallel.
+ * @param box The box to be looped over
+ * @param func The function, which takes a `const Position<N>&` as parameter
+ * @param grainSize The maximum number of positions per grain
+ * @param pool The thread pool
+ * @details
+ * Within a grain, positions are visited in storage order.
+ * The function must be safe to call concurrently for different positions,
+ * e.g. write only at the given position.
+ *
+ * \par_example
+ * \code
+ * parallelForEach(out.domain(), [&](const auto& p) {
+ *   out[p] = in[p] * in[p];
+ * });
+ * \endcode
+ */
+template <Index N, typename TFunc>
+void parallelForEach(
+    const Box<N>& box,
+    TFunc&& func,
+    Index grainSize = defaultGrainSize,
+    ThreadPool& pool = ThreadPool::global()) {
+  parallelForEachGrain(
+      box,
+      [&](const Box<N>& grain) {
+        for (const auto& p : grain) {
+          func(p);
+        }
+      },
+      grainSize,
+      pool);
+}
+
+/**
+ * @relates Box
+ * @brief Apply a function to each row of a box in parallel.
+ * @param box The box to be looped over
+ * @param func The function, which takes the front position of the row (`const Position<N>&`)
+ * and the row length (`Index`) as parameters
+ * @param grainSize The maximum number of positions per grain
+ * @param pool The thread pool
+ * @details
+ * A row is the maximal segment of the box along axis 0, i.e. which is contiguous in raster memory.
+ * Rows are never split, such that the function can work on raw pointers, e.g.:
+ * \code
+ * parallelForEachRow(raster.domain(), [&](const auto& front, Index length) {
+ *   auto* it = &raster[front];
+ *   std::fill(it, it + length, 0);
+ * });
+ * \endcode
+ */
+template <Index N, typename TFunc>
+void parallelForEachRow(
+    const Box<N>& box,
+    TFunc&& func,
+    Index grainSize = defaultGrainSize,
+    ThreadPool& pool = ThreadPool::global()) {
+  const auto grains = partition(box, grainSize, 1);
+  const auto length = box.size() > 0 ? box.length(0) : 0;
+  pool.run(grains.size(), [&](std::size_t i) {
+    for (const auto& p : project(grains[i])) {
+      func(p, length);
+    }
+  });
+}
+
+} // namespace Litl
+
+#endif
@@ -5,10 +5,13 @@
 #ifndef _LITLRASTER_RASTER_H
 #define _LITLRASTER_RASTER_H
 
+#include "LitlContainer/AdoptedBuffer.h"
 #include "LitlContainer/AlignedBuffer.h"
+#include "LitlContainer/Arena.h"
 #include "LitlContainer/DataContainer.h"
 #include "LitlContainer/Random.h"
 #include "LitlRaster/Box.h"
+#include "LitlRaster/Enumeration.h"
 #include "LitlTypes/Exceptions.h"
 
 #include <complex>
@@ -93,6 +96,46 @@ using ArrRaster = Raster<T, N, StdHolder<std::array<T, Capacity>>>;
 template <typename T, Index N = 2>
 using AlignedRaster = Raster<T, N, AlignedBuffer<T>>;
 
+/**
+ * @ingroup data_classes
+ * @brief `Raster` which adopts some externally allocated memory.
+ * @details
+ * `AdoptedBuffer<T>` takes ownership of a pointer together with the function which releases it,
+ * e.g. to use data produced by some third-party library without copy:
+ * \code
+ * AdoptedRaster<float> raster({width, height}, data, [](float* p) {
+ *   std::free(p);
+ * });
+ * \endcode
+ */
+template <typename T, Index N = 2>
+using AdoptedRaster = Raster<T, N, AdoptedBuffer<T>>;
+
+/**
+ * @ingroup data_classes
+ * @brief `Raster` which allocates from the current `Arena` of the thread, if any.
+ * @details
+ * This is the preferred output type of per-frame temporaries, which are then all released at once with the arena.
+ * @see ArenaScope
+ */
+template <typename T, Index N = 2>
+using ArenaRaster = VecRaster<T, N, ArenaAllocator<T>>;
+
+#ifdef LITL_HAS_PMR
+
+/**
+ * @ingroup data_classes
+ * @brief `Raster` which allocates from a `std::pmr::memory_resource`.
+ * @details
+ * The memory resource is the default resource at construction, see `std::pmr::set_default_resource()`,
+ * or that of the container which is moved in.
+ * @see ArenaResource
+ */
+template <typename T, Index N = 2>
+using PmrRaster = VecRaster<T, N, std::pmr::polymorphic_allocator<T>>;
+
+#endif
+
 /**
  * @ingroup data_classes
  * @brief Data of a N-dimensional image (2D by default).
@@ -138,6 +181,8 @@ using AlignedRaster = Raster<T, N, AlignedBuffer<T>>;
  * @tspecialization{ValRaster}
  * @tspecialization{ArrRaster}
  * @tspecialization{AlignedRaster}
+ * @tspecialization{AdoptedRaster}
+ * @tspecialization{ArenaRaster}
  * 
  * @satisfies{ContiguousContainer}
  * @satisfies{EuclidArithmetic}
@@ -188,7 +233,8 @@ public:
    */
   template <typename... TArgs>
   explicit Raster(Position<N> shape = Position<N>::zero(), TArgs&&... args) :
-      Container(shapeSize(shape), std::forward<TArgs>(args)...), m_shape(std::move(shape)) {}
+      Container(shapeSize(shape), std::forward<TArgs>(args)...), m_shape(std::move(shape)),
+      m_strides(shapeStrides(m_shape)) {}
 
   /**
    * @brief List-copy constructor.
@@ -204,8 +250,8 @@ public:
    */
   template <typename U, typename... TArgs>
   explicit Raster(Position<N> shape, std::initializer_list<U> list, TArgs&&... args) :
-      Container(list, std::forward<TArgs>(args)...), m_shape(std::move(shape)) {
-    SizeError::mayThrow(list.size(), shapeSize(shape));
+      Container(list, std::forward<TArgs>(args)...), m_shape(std::move(shape)), m_strides(shapeStrides(m_shape)) {
+    SizeError::mayThrow(list.size(), shapeSize(m_shape));
   }
 
   /**
@@ -222,8 +268,8 @@ public:
    */
   template <typename TIterable, typename std::enable_if_t<isIterable<TIterable>::value>* = nullptr, typename... TArgs>
   explicit Raster(Position<N> shape, TIterable& iterable, TArgs&&... args) :
-      Container(iterable, std::forward<TArgs>(args)...), m_shape(std::move(shape)) {
-    SizeError::mayThrow(std::distance(std::begin(iterable), std::end(iterable)), shapeSize(shape));
+      Container(iterable, std::forward<TArgs>(args)...), m_shape(std::move(shape)), m_strides(shapeStrides(m_shape)) {
+    SizeError::mayThrow(std::distance(std::begin(iterable), std::end(iterable)), shapeSize(m_shape));
   }
 
   /// @group_properties
@@ -282,6 +328,22 @@ public:
     return m_shape[i];
   }
 
+  /**
+   * @brief Get the strides, i.e. the index jumps along each axis.
+   * @details
+   * Strides are computed once at construction.
+   */
+  const Position<N>& strides() const {
+    return m_strides;
+  }
+
+  /**
+   * @brief Get the stride along given axis.
+   */
+  Index stride(Index i) const {
+    return m_strides[i];
+  }
+
   /// @group_elements
 
   using Container::operator[];
@@ -289,9 +351,34 @@ public:
 
   /**
    * @brief Compute the raw index of a given position.
+   * @details
+   * The index is the dot product of the position and the strides.
    */
   inline Index index(const Position<N>& pos) const;
 
+  /**
+   * @brief Enumerate the positions of a region and their raw indices.
+   * @details
+   * This is the region-wise counterpart of `index()`,
+   * where indices are computed incrementally instead of for each position:
+   * \code
+   * for (const auto& e : raster.enumerate(box)) {
+   *   out[e.index] = f(e.position, raster[e.index]);
+   * }
+   * \endcode
+   * @see Enumeration
+   */
+  Enumeration<N> enumerate(Box<N> region) const {
+    return {std::move(region), m_strides};
+  }
+
+  /**
+   * @brief Enumerate the positions of the domain and their raw indices.
+   */
+  Enumeration<N> enumerate() const {
+    return enumerate(domain());
+  }
+
   /**
    * @brief Access the pixel value at given position.
    */
@@ -405,6 +492,11 @@ private:
    * @brief Raster shape, i.e. length along each axis.
    */
   Position<N> m_shape;
+
+  /**
+   * @brief Raster strides, i.e. index jump along each axis.
+   */
+  Position<N> m_strides;
 };
 
 /**
@@ -0,0 +1,280 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLRASTER_REGIONCOPY_H
+#define _LITLRASTER_REGIONCOPY_H
+
+#include "LitlRaster/ParallelFor.h"
+#include "LitlRaster/Raster.h"
+
+#include <algorithm> // copy_n, max, min
+#include <cmath> // abs, round
+#include <cstring> // memcpy
+#include <functional> // less
+#include <limits> // numeric_limits
+#include <type_traits> // enable_if, is_integral, is_same, is_trivially_copyable, remove_const
+
+namespace Litl {
+
+/// @cond INTERNAL
+namespace Internal {
+
+/**
+ * @brief Clip a source region and its destination to the source and destination domains.
+ * @param srcShape The source raster shape
+ * @param srcBox The source region, clipped in place
+ * @param dstShape The destination raster shape
+ * @param dstPos The destination of the source region front, shifted in place
+ * @return False if the clipped region is empty
+ */
+template <Index N>
+bool clipRegion(const Position<N>& srcShape, Box<N>& srcBox, const Position<N>& dstShape, Position<N>& dstPos) {
+  auto front = srcBox.front();
+  auto back = srcBox.back();
+  for (std::size_t i = 0; i < front.size(); ++i) {
+    const auto offset = dstPos[i] - front[i];
+    front[i] = std::max({front[i], Index(0), -offset});
+    back[i] = std::min({back[i], srcShape[i] - 1, dstShape[i] - 1 - offset});
+    if (front[i] > back[i]) {
+      return false;
+    }
+    dstPos[i] = front[i] + offset;
+  }
+  srcBox = Box<N>(front, back);
+  return true;
+}
+
+/**
+ * @brief Copy a row, with `memcpy()` when possible.
+ */
+template <typename T, typename U>
+std::enable_if_t<std::is_same<std::remove_const_t<T>, U>::value && std::is_trivially_copyable<U>::value>
+copyRow(const T* in, Index length, U* out) {
+  std::memcpy(out, in, length * sizeof(U));
+}
+
+/**
+ * @brief Copy a row, with conversion.
+ */
+template <typename T, typename U>
+std::enable_if_t<not(std::is_same<std::remove_const_t<T>, U>::value && std::is_trivially_copyable<U>::value)>
+copyRow(const T* in, Index length, U* out) {
+  std::copy_n(in, length, out);
+}
+
+/**
+ * @brief Check whether the memory of a source region and of its destination overlap.
+ */
+template <typename TIn, typename TOut>
+bool regionsOverlap(
+    const TIn& src,
+    const Box<TIn::Dimension>& srcBox,
+    const TOut& dst,
+    const Box<TIn::Dimension>& dstBox) {
+  const auto* srcBegin = reinterpret_cast<const char*>(&src[srcBox.front()]);
+  const auto* srcEnd = reinterpret_cast<const char*>(&src[srcBox.back()] + 1);
+  const auto* dstBegin = reinterpret_cast<const char*>(&dst[dstBox.front()]);
+  const auto* dstEnd = reinterpret_cast<const char*>(&dst[dstBox.back()] + 1);
+  const std::less<const char*> less;
+  return less(srcBegin, dstEnd) && less(dstBegin, srcEnd);
+}
+
+/**
+ * @brief Blend a value into a non-integral value, with weights of the real type of the output.
+ */
+template <typename TIn, typename TOut>
+void blendValue(const TIn& in, TOut& out, double alpha, double beta, std::false_type) {
+  using Weight = decltype(std::abs(out));
+  out = Weight(alpha) * in + Weight(beta) * out;
+}
+
+/**
+ * @brief Blend a value into an integral value, rounded to nearest and saturated.
+ */
+template <typename TIn, typename TOut>
+void blendValue(const TIn& in, TOut& out, double alpha, double beta, std::true_type) {
+  const auto blended = std::round(alpha * double(in) + beta * double(out));
+  if (blended <= double(std::numeric_limits<TOut>::lowest())) {
+    out = std::numeric_limits<TOut>::lowest();
+  } else if (blended >= double(std::numeric_limits<TOut>::max())) {
+    out = std::numeric_limits<TOut>::max();
+  } else {
+    out = static_cast<TOut>(blended);
+  }
+}
+
+} // namespace Internal
+/// @endcond
+
+/**
+ * @ingroup pixelwise
+ * @brief Apply a function to each row of a region of a raster and the corresponding row of another raster.
+ * @param src The source raster
+ * @param srcBox The source region
+ * @param dst The destination raster
+ * @param dstPos The destination position of the front of `srcBox`
+ * @param func The row function, which takes as parameters the source row (`const T*`),
+ * its length (`Index`) and the destination row (`U*`)
+ * @param pool The thread pool
+ * @details
+ * The region is clipped to the source domain, and its destination to the destination domain,
+ * such that it is safe to copy cutouts at or across the borders.
+ * The rows are processed in parallel if the region is large, and serially otherwise,
+ * such that processing many small stamps is not penalized by scheduling.
+ * If the source region and its destination overlap in memory, e.g. to shift a region inside a raster,
+ * the source region is first copied to a temporary raster, such that no row is read after it was written.
+ *
+ * This is the building block of `copyRegion()`, `addRegion()` and `blendRegion()`.
+ */
+template <typename TIn, typename TOut, typename TFunc>
+void forEachRegionRow(
+    const TIn& src,
+    Box<TIn::Dimension> srcBox,
+    TOut& dst,
+    Position<TIn::Dimension> dstPos,
+    TFunc&& func,
+    ThreadPool& pool = ThreadPool::global()) {
+  if (not Internal::clipRegion(src.shape(), srcBox, dst.shape(), dstPos)) {
+    return;
+  }
+  const auto offset = dstPos - srcBox.front();
+  if (Internal::regionsOverlap(src, srcBox, dst, srcBox + offset)) {
+    Raster<std::remove_const_t<typename TIn::Value>, TIn::Dimension> buffer(srcBox.shape());
+    const auto length = srcBox.length(0);
+    for (const auto& p : project(srcBox)) {
+      Internal::copyRow(&src[p], length, &buffer[p - srcBox.front()]);
+    }
+    forEachRegionRow(buffer, buffer.domain(), dst, dstPos, std::forward<TFunc>(func), pool);
+    return;
+  }
+  const auto processRow = [&](const Position<TIn::Dimension>& front, Index length) {
+    func(&src[front], length, &dst[front + offset]);
+  };
+  if (Index(srcBox.size()) <= defaultGrainSize) {
+    const auto length = srcBox.length(0);
+    for (const auto& p : project(srcBox)) {
+      processRow(p, length);
+    }
+  } else {
+    parallelForEachRow(srcBox, processRow, defaultGrainSize, pool);
+  }
+}
+
+/**
+ * @ingroup pixelwise
+ * @brief Copy a region of a raster into another raster.
+ * @param src The source raster
+ * @param srcBox The source region
+ * @param dst The destination raster
+ * @param dstPos The destination position of the front of `srcBox`
+ * @param pool The thread pool
+ * @details
+ * Rows are copied with `memcpy()` if the value types are the same, or converted otherwise.
+ * @see forEachRegionRow() for clipping and parallelization
+ *
+ * \par_example
+ * \code
+ * copyRegion(image, Box<2>::fromCenter(radius, center), cutout, Position<2>::zero()); // Extract
+ * copyRegion(cutout, cutout.domain(), mosaic, offset); // Paste
+ * \endcode
+ */
+template <typename TIn, typename TOut>
+void copyRegion(
+    const TIn& src,
+    const Box<TIn::Dimension>& srcBox,
+    TOut& dst,
+    const Position<TIn::Dimension>& dstPos,
+    ThreadPool& pool = ThreadPool::global()) {
+  forEachRegionRow(
+      src,
+      srcBox,
+      dst,
+      dstPos,
+      [](const auto* in, Index length, auto* out) {
+        Internal::copyRow(in, length, out);
+      },
+      pool);
+}
+
+/**
+ * @ingroup pixelwise
+ * @brief Add a region of a raster to another raster, optionally scaled.
+ * @param src The source raster
+ * @param srcBox The source region
+ * @param dst The destination raster
+ * @param dstPos The destination position of the front of `srcBox`
+ * @param factor The scaling factor of the source values
+ * @param pool The thread pool
+ * @details
+ * This is typically used to stamp a PSF with some flux into a mosaic.
+ * @see forEachRegionRow() for clipping and parallelization
+ */
+template <typename TIn, typename TOut>
+void addRegion(
+    const TIn& src,
+    const Box<TIn::Dimension>& srcBox,
+    TOut& dst,
+    const Position<TIn::Dimension>& dstPos,
+    typename TOut::Value factor = 1,
+    ThreadPool& pool = ThreadPool::global()) {
+  forEachRegionRow(
+      src,
+      srcBox,
+      dst,
+      dstPos,
+      [=](const auto* in, Index length, auto* out) {
+        if (factor == 1) {
+          for (Index i = 0; i < length; ++i) {
+            out[i] += in[i];
+          }
+        } else {
+          for (Index i = 0; i < length; ++i) {
+            out[i] += factor * in[i];
+          }
+        }
+      },
+      pool);
+}
+
+/**
+ * @ingroup pixelwise
+ * @brief Blend a region of a raster into another raster.
+ * @param src The source raster
+ * @param srcBox The source region
+ * @param dst The destination raster
+ * @param dstPos The destination position of the front of `srcBox`
+ * @param alpha The opacity of the source, between 0 and 1
+ * @param pool The thread pool
+ * @details
+ * Destination values are replaced with `alpha * src + (1 - alpha) * dst`.
+ * The blending is computed in floating point, and rounded to nearest and saturated for integral destinations,
+ * such that fractional opacities apply to integral rasters too.
+ * @see forEachRegionRow() for clipping and parallelization
+ */
+template <typename TIn, typename TOut>
+void blendRegion(
+    const TIn& src,
+    const Box<TIn::Dimension>& srcBox,
+    TOut& dst,
+    const Position<TIn::Dimension>& dstPos,
+    double alpha,
+    ThreadPool& pool = ThreadPool::global()) {
+  using IsIntegral = std::is_integral<std::remove_const_t<typename TOut::Value>>;
+  const auto beta = 1 - alpha;
+  forEachRegionRow(
+      src,
+      srcBox,
+      dst,
+      dstPos,
+      [=](const auto* in, Index length, auto* out) {
+        for (Index i = 0; i < length; ++i) {
+          Internal::blendValue(in[i], out[i], alpha, beta, IsIntegral());
+        }
+      },
+      pool);
+}
+
+} // namespace Litl
+
+#endif
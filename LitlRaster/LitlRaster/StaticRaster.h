@@ -0,0 +1,245 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLRASTER_STATICRASTER_H
+#define _LITLRASTER_STATICRASTER_H
+
+#include "LitlRaster/Raster.h"
+
+namespace Litl {
+
+/**
+ * @ingroup data_classes
+ * @brief Raster with compile-time shape and inline storage.
+ * @tparam T The value type
+ * @tparam Ls The lengths along each axis
+ * @details
+ * This class is intended for small, fixed-size arrays like stamps, patches or kernel values,
+ * which are processed in large numbers.
+ * Values are stored in an `std::array`, such that no allocation occurs,
+ * and strides and lengths are compile-time constants,
+ * which lets the compiler fully unroll and vectorize loops.
+ *
+ * The class provides the same interface as `Raster` where relevant
+ * (e.g. `shape()`, `domain()`, `index()`, `operator[]()`),
+ * and can therefore be used in place of a `Raster` in the algorithms which take a raster template parameter,
+ * e.g. wrapped in an `Extrapolator`.
+ * Where an actual `Raster` is required, `view()` creates a `PtrRaster` of the data.
+ *
+ * The only overhead over the values is the virtual table pointer of `DataContainer`.
+ *
+ * \par_example
+ * \code
+ * StaticRaster<float, 32, 32> stamp;
+ * stamp.fill(0);
+ * for (Index y = 0; y < stamp.length<1>(); ++y) { // Fully unrolled
+ *   for (Index x = 0; x < stamp.length<0>(); ++x) {
+ *     stamp[{x, y}] = x * y;
+ *   }
+ * }
+ * \endcode
+ *
+ * @satisfies{ContiguousContainer}
+ * @satisfies{EuclidArithmetic}
+ */
+template <typename T, Index... Ls>
+class StaticRaster :
+    public DataContainer<T, StdHolder<std::array<T, shapeSize<Ls...>()>>, EuclidArithmetic, StaticRaster<T, Ls...>> {
+
+public:
+  /**
+   * @brief The pixel value type.
+   */
+  using Value = T;
+
+  /**
+   * @brief The dimension.
+   */
+  static constexpr Index Dimension = sizeof...(Ls);
+
+  /**
+   * @brief The number of pixels.
+   */
+  static constexpr Index Size = shapeSize<Ls...>();
+
+  /**
+   * @brief The container type.
+   */
+  using Container = DataContainer<T, StdHolder<std::array<T, Size>>, EuclidArithmetic, StaticRaster<T, Ls...>>;
+
+  /// @{
+  /// @group_construction
+
+  LITL_DEFAULT_COPYABLE(StaticRaster)
+  LITL_DEFAULT_MOVABLE(StaticRaster)
+
+  /**
+   * @brief Default constructor.
+   * @details
+   * Values are value-initialized.
+   */
+  StaticRaster() : Container(Size) {}
+
+  /**
+   * @brief Pointer-copy constructor.
+   */
+  explicit StaticRaster(const T* data) : Container(Size, data) {}
+
+  /**
+   * @brief List-copy constructor.
+   */
+  template <typename U>
+  StaticRaster(std::initializer_list<U> list) : Container(Size) {
+    SizeError::mayThrow(list.size(), Size);
+    std::copy(list.begin(), list.end(), this->data());
+  }
+
+  /**
+   * @brief Iterable-copy constructor.
+   */
+  template <typename TIterable, typename std::enable_if_t<isIterable<TIterable>::value>* = nullptr>
+  explicit StaticRaster(const TIterable& iterable) : Container(Size) {
+    SizeError::mayThrow(std::distance(std::begin(iterable), std::end(iterable)), Size);
+    std::copy(std::begin(iterable), std::end(iterable), this->data());
+  }
+
+  /// @group_properties
+
+  /**
+   * @brief Get the raster shape.
+   */
+  static const Position<Dimension>& shape() {
+    static const Position<Dimension> out {Ls...};
+    return out;
+  }
+
+  /**
+   * @brief Get the raster domain.
+   */
+  static Box<Dimension> domain() {
+    return Box<Dimension>::fromShape(Position<Dimension>::zero(), shape());
+  }
+
+  /**
+   * @brief Get the dimension.
+   */
+  static constexpr Index dimension() {
+    return Dimension;
+  }
+
+  /**
+   * @brief Get the length along given axis.
+   */
+  template <Index I>
+  static constexpr Index length() {
+    return length(I);
+  }
+
+  /**
+   * @copydoc length()
+   */
+  static constexpr Index length(Index i) {
+    constexpr Index lengths[] = {Ls..., 0};
+    return lengths[i];
+  }
+
+  /**
+   * @brief Get the stride along given axis.
+   */
+  template <Index I>
+  static constexpr Index stride() {
+    return stride(I);
+  }
+
+  /**
+   * @copydoc stride()
+   */
+  static constexpr Index stride(Index i) {
+    constexpr Index lengths[] = {Ls..., 0};
+    Index out = 1;
+    for (Index j = 0; j < i; ++j) {
+      out *= lengths[j];
+    }
+    return out;
+  }
+
+  /**
+   * @brief Check whether a given (possibly non-integral) position lies inside the raster domain.
+   */
+  template <typename U>
+  static bool contains(const Vector<U, Dimension>& position) {
+    for (Index i = 0; i < Dimension; ++i) {
+      if (position[i] < 0 || position[i] >= length(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// @group_elements
+
+  using Container::operator[];
+  using Container::at;
+
+  /**
+   * @brief Compute the raw index of a given position.
+   * @details
+   * The index is the dot product of the position and the compile-time strides.
+   */
+  static inline Index index(const Position<Dimension>& pos) {
+    Index out = 0;
+    for (Index i = 0; i < Dimension; ++i) {
+      out += pos[i] * stride(i);
+    }
+    return out;
+  }
+
+  /**
+   * @brief Access the pixel value at given position.
+   */
+  inline const T& operator[](const Position<Dimension>& pos) const {
+    return (*this)[index(pos)];
+  }
+
+  /**
+   * @copybrief operator[]()
+   */
+  inline T& operator[](const Position<Dimension>& pos) {
+    return (*this)[index(pos)];
+  }
+
+  /// @group_views
+
+  /**
+   * @brief View the data as a `PtrRaster`.
+   */
+  const PtrRaster<const T, Dimension> view() const {
+    return PtrRaster<const T, Dimension>(shape(), this->data());
+  }
+
+  /**
+   * @copybrief view()
+   */
+  PtrRaster<T, Dimension> view() {
+    return PtrRaster<T, Dimension>(shape(), this->data());
+  }
+
+  /// @}
+};
+
+/**
+ * @relates StaticRaster
+ * @brief Identity.
+ * @details
+ * This function is provided for compatibility with `Extrapolator`
+ * in cases where functions accept either a raster or an `Extrapolator`.
+ */
+template <typename T, Index... Ls>
+const StaticRaster<T, Ls...>& rasterize(const StaticRaster<T, Ls...>& in) {
+  return in;
+}
+
+} // namespace Litl
+
+#endif
@@ -0,0 +1,383 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLRASTER_THREADPOOL_H
+#define _LITLRASTER_THREADPOOL_H
+
+#include "LitlTypes/TypeUtils.h"
+
+#include <algorithm> // max
+#include <condition_variable>
+#include <cstddef> // size_t
+#include <exception> // exception_ptr
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Litl {
+
+/**
+ * @brief Pool of worker threads which execute batches of indexed tasks with work stealing.
+ * @details
+ * A batch of `n` tasks is identified by the indices 0 to `n - 1`.
+ * When a batch is run, the indices are first dealt as contiguous ranges, one per thread,
+ * such that consecutive tasks tend to be executed by the same thread.
+ * Each thread pops the tasks from the front of its own range,
+ * and once its range is empty, it steals tasks from the back of the ranges of other threads.
+ *
+ * The calling thread participates to the batch, and `run()` returns when all the tasks are completed.
+ * If a task throws, the remaining tasks are still executed, and the first exception is rethrown by `run()`.
+ *
+ * Batches which are run from inside a task are executed sequentially by the calling thread,
+ * which prevents deadlocks in case of nested parallelism.
+ *
+ * A global pool with as many threads as hardware threads is accessible as `ThreadPool::global()`.
+ *
+ * \par_example
+ * \code
+ * std::vector<double> values(1000);
+ * ThreadPool::global().run(values.size(), [&](std::size_t i) {
+ *   values[i] = std::sqrt(i);
+ * });
+ * \endcode
+ */
+class ThreadPool {
+
+public:
+  /// @{
+  /// @group_construction
+
+  /**
+   * @brief Constructor.
+   * @param threadCount The number of threads including the calling thread, or 0 for the hardware concurrency
+   * @details
+   * `threadCount - 1` worker threads are spawned at construction.
+   * With `threadCount = 1`, tasks are executed sequentially by the calling thread.
+   */
+  explicit ThreadPool(std::size_t threadCount = 0) :
+      m_ranges(threadCount ? threadCount : hardwareConcurrency()), m_workers(), m_mutex(), m_wakeUp(), m_done(),
+      m_generation(0), m_active(0), m_stop(false), m_run(), m_task(nullptr), m_error() {
+    m_workers.reserve(m_ranges.size() - 1);
+    for (std::size_t i = 1; i < m_ranges.size(); ++i) {
+      m_workers.emplace_back([this, i]() {
+        work(i);
+      });
+    }
+  }
+
+  LITL_NON_COPYABLE(ThreadPool)
+  LITL_NON_MOVABLE(ThreadPool)
+
+  /**
+   * @brief Destructor.
+   * @details
+   * Waits for the worker threads to terminate.
+   */
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wakeUp.notify_all();
+    for (auto& w : m_workers) {
+      w.join();
+    }
+  }
+
+  /**
+   * @brief Get the global pool.
+   * @details
+   * This is a Meyer's singleton with as many threads as hardware threads.
+   */
+  static ThreadPool& global() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  /**
+   * @brief Get the number of hardware threads, or 1 if unknown.
+   */
+  static std::size_t hardwareConcurrency() {
+    return std::max(std::thread::hardware_concurrency(), 1U);
+  }
+
+  /// @group_properties
+
+  /**
+   * @brief Get the number of threads, including the calling thread.
+   */
+  std::size_t threadCount() const {
+    return m_ranges.size();
+  }
+
+  /**
+   * @brief Check whether the current thread is executing a task.
+   */
+  static bool isInTask() {
+    return inTask();
+  }
+
+  /// @group_operations
+
+  /**
+   * @brief Run a batch of tasks and wait for their completion.
+   * @param taskCount The number of tasks
+   * @param func The task function, which takes the task index as parameter
+   * @details
+   * If another batch is running, the call blocks until it is completed.
+   */
+  template <typename TFunc>
+  void run(std::size_t taskCount, TFunc&& func) {
+    if (runSequentially(taskCount, func)) {
+      return;
+    }
+    std::lock_guard<std::mutex> batchLock(m_run); // One batch at a time
+    runBatch(taskCount, func);
+  }
+
+  /**
+   * @brief Run a batch of tasks and wait for their completion, unless another batch is running.
+   * @param taskCount The number of tasks
+   * @param func The task function, which takes the task index as parameter
+   * @return `false` if nothing was run because the pool is busy, `true` otherwise
+   * @details
+   * This allows callers which can work sequentially to do so instead of waiting for the workers.
+   */
+  template <typename TFunc>
+  bool tryRun(std::size_t taskCount, TFunc&& func) {
+    if (runSequentially(taskCount, func)) {
+      return true;
+    }
+    std::unique_lock<std::mutex> batchLock(m_run, std::try_to_lock);
+    if (not batchLock.owns_lock()) {
+      return false;
+    }
+    runBatch(taskCount, func);
+    return true;
+  }
+
+  /// @}
+
+private:
+  /**
+   * @brief Run a batch in the calling thread if it is not worth waking up the workers, or if they could deadlock.
+   * @return `true` if the batch was run
+   * @details
+   * Like with `runBatch()`, all the tasks are run even if some throw, and the first exception is rethrown.
+   */
+  template <typename TFunc>
+  bool runSequentially(std::size_t taskCount, TFunc& func) const {
+    if (taskCount > 1 && not m_workers.empty() && not inTask()) {
+      return false;
+    }
+    std::exception_ptr error;
+    for (std::size_t i = 0; i < taskCount; ++i) {
+      try {
+        func(i);
+      } catch (...) {
+        if (not error) {
+          error = std::current_exception();
+        }
+      }
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Run a batch on all the threads, while holding the batch lock.
+   */
+  template <typename TFunc>
+  void runBatch(std::size_t taskCount, TFunc& func) {
+    const std::function<void(std::size_t)> task(std::ref(func));
+    const auto count = m_ranges.size();
+    for (std::size_t r = 0; r < count; ++r) {
+      m_ranges[r].reset(taskCount * r / count, taskCount * (r + 1) / count);
+    }
+    m_task = &task;
+    m_error = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_active = m_workers.size();
+      ++m_generation;
+    }
+    m_wakeUp.notify_all();
+    process(0);
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_done.wait(lock, [&]() {
+        return m_active == 0;
+      });
+    }
+    m_task = nullptr;
+    if (m_error) {
+      std::rethrow_exception(m_error);
+    }
+  }
+
+  /**
+   * @brief Range of task indices owned by a thread.
+   */
+  struct TaskRange {
+
+    /**
+     * @brief Set the range bounds (back excluded).
+     */
+    void reset(std::size_t f, std::size_t b) {
+      std::lock_guard<std::mutex> lock(mutex);
+      front = f;
+      back = b;
+    }
+
+    /**
+     * @brief Pop a task from the front, if any.
+     */
+    bool pop(std::size_t& index) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (front == back) {
+        return false;
+      }
+      index = front++;
+      return true;
+    }
+
+    /**
+     * @brief Steal a task from the back, if any.
+     */
+    bool steal(std::size_t& index) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (front == back) {
+        return false;
+      }
+      index = --back;
+      return true;
+    }
+
+    std::mutex mutex;
+    std::size_t front = 0;
+    std::size_t back = 0;
+  };
+
+  /**
+   * @brief Flag of the threads which are executing tasks.
+   */
+  static bool& inTask() {
+    static thread_local bool flag = false;
+    return flag;
+  }
+
+  /**
+   * @brief Worker thread loop.
+   */
+  void work(std::size_t r) {
+    std::size_t generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wakeUp.wait(lock, [&]() {
+          return m_stop || m_generation != generation;
+        });
+        if (m_stop) {
+          return;
+        }
+        generation = m_generation;
+      }
+      process(r);
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_active;
+      }
+      m_done.notify_one();
+    }
+  }
+
+  /**
+   * @brief Execute the tasks of a given range, and then steal tasks from the other ranges.
+   */
+  void process(std::size_t r) {
+    inTask() = true;
+    const auto count = m_ranges.size();
+    std::size_t index;
+    while (true) {
+      bool found = m_ranges[r].pop(index);
+      for (std::size_t v = 1; not found && v < count; ++v) {
+        found = m_ranges[(r + v) % count].steal(index);
+      }
+      if (not found) {
+        break;
+      }
+      try {
+        (*m_task)(index);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (not m_error) {
+          m_error = std::current_exception();
+        }
+      }
+    }
+    inTask() = false;
+  }
+
+  /**
+   * @brief The task ranges, one per thread.
+   */
+  std::vector<TaskRange> m_ranges;
+
+  /**
+   * @brief The worker threads.
+   */
+  std::vector<std::thread> m_workers;
+
+  /**
+   * @brief The state mutex.
+   */
+  std::mutex m_mutex;
+
+  /**
+   * @brief The condition to start a batch or stop.
+   */
+  std::condition_variable m_wakeUp;
+
+  /**
+   * @brief The condition to end a batch.
+   */
+  std::condition_variable m_done;
+
+  /**
+   * @brief The batch counter.
+   */
+  std::size_t m_generation;
+
+  /**
+   * @brief The number of workers which did not complete the current batch.
+   */
+  std::size_t m_active;
+
+  /**
+   * @brief The stop flag.
+   */
+  bool m_stop;
+
+  /**
+   * @brief The batch mutex.
+   */
+  std::mutex m_run;
+
+  /**
+   * @brief The current task function.
+   */
+  const std::function<void(std::size_t)>* m_task;
+
+  /**
+   * @brief The first exception thrown by the current batch.
+   */
+  std::exception_ptr m_error;
+};
+
+} // namespace Litl
+
+#endif
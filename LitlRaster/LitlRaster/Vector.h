@@ -213,6 +213,24 @@ Index shapeStride(const Position<N>& shape) {
   return shapeStride(shape, Axis);
 }
 
+/**
+ * @relates Position
+ * @brief Get the strides along all axes.
+ * @details
+ * This is equivalent to calling `shapeStride()` for each axis,
+ * with a single pass over the shape.
+ */
+template <Index N>
+Position<N> shapeStrides(const Position<N>& shape) {
+  Position<N> out(shape.size());
+  Index stride = 1;
+  for (std::size_t i = 0; i < shape.size(); ++i) {
+    out[i] = stride;
+    stride *= shape[i];
+  }
+  return out;
+}
+
 /**
  * @relates Position
  * @brief Compute the number of pixels in a given shape.
@@ -226,6 +244,20 @@ Index shapeSize(const Position<N>& shape) {
   return shapeStride(shape, size);
 }
 
+/**
+ * @relates Position
+ * @brief Compute the number of pixels in a given compile-time shape.
+ */
+template <Index... Ls>
+constexpr Index shapeSize() {
+  const Index lengths[] = {Ls..., 0};
+  Index out = sizeof...(Ls) > 0;
+  for (std::size_t i = 0; i < sizeof...(Ls); ++i) {
+    out *= lengths[i];
+  }
+  return out;
+}
+
 } // namespace Litl
 
 #endif
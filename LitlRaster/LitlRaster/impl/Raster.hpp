@@ -69,6 +69,46 @@ struct IndexRecursionImpl<-1, I> {
   }
 };
 
+/**
+ * @brief Dot product of a position and strides.
+ */
+template <Index N>
+struct StrideDotImpl {
+
+  /**
+   * @brief pos[0] * strides[0] + pos[1] * strides[1] + ...
+   */
+  static Index index(const Position<N>& strides, const Position<N>& pos) {
+    Index res = 0;
+    for (Index i = 0; i < N; ++i) {
+      res += pos[i] * strides[i];
+    }
+    return res;
+  }
+};
+
+/**
+ * @brief Variable dimension case.
+ */
+template <>
+struct StrideDotImpl<-1> {
+
+  /**
+   * @brief pos[0] * strides[0] + pos[1] * strides[1] + ...
+   */
+  static Index index(const Position<-1>& strides, const Position<-1>& pos) {
+    const auto n = strides.size();
+    SizeError::mayThrow(pos.size(), n);
+    const auto* s = strides.data();
+    const auto* p = pos.data();
+    Index res = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      res += p[i] * s[i];
+    }
+    return res;
+  }
+};
+
 } // namespace Internal
 /// @endcond
 
@@ -97,7 +137,7 @@ inline Index Raster<T, N, THolder>::length() const {
 
 template <typename T, Index N, typename THolder>
 inline Index Raster<T, N, THolder>::index(const Position<N>& pos) const {
-  return Internal::IndexRecursionImpl<N>::index(m_shape, pos);
+  return Internal::StrideDotImpl<N>::index(m_strides, pos);
 }
 
 template <typename T, Index N, typename THolder>
@@ -0,0 +1,81 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlRaster/ContentHash.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(ContentHash_test)
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(hash_bytes_test) {
+  // Reference values of xxHash64
+  BOOST_TEST(hashBytes("", 0) == 0xEF46DB3751D8E999ULL);
+  BOOST_TEST(hashBytes("a", 1) == 0xD24EC4F1A98C6E5BULL);
+  BOOST_TEST(hashBytes("abc", 3) == 0x44BC2CF5AD770999ULL);
+  const std::string text = "Nobody inspects the spammish repetition";
+  BOOST_TEST(hashBytes(text.data(), text.size()) == 0xFBCEA83C8A378BF1ULL);
+  BOOST_TEST(hashBytes("abc", 3, 1) != hashBytes("abc", 3));
+}
+
+BOOST_AUTO_TEST_CASE(hash_values_test) {
+  BOOST_TEST(hashValues(1, 2.) == hashValues(1, 2.));
+  BOOST_TEST(hashValues(1, 2.) != hashValues(2, 1.));
+  BOOST_TEST(hashValues(1, 2.) != hashValues(1, 2.f));
+}
+
+BOOST_AUTO_TEST_CASE(type_shape_and_values_are_hashed_test) {
+  Raster<int, 3> raster({40, 30, 20});
+  raster.range();
+  const auto reference = contentHash(raster);
+  BOOST_TEST(contentHash(raster) == reference);
+  Raster<int, 3> reshaped({30, 40, 20}, raster.data());
+  BOOST_TEST(contentHash(reshaped) != reference);
+  Raster<unsigned, 3> converted(raster.shape(), reinterpret_cast<const unsigned*>(raster.data()));
+  BOOST_TEST(contentHash(converted) != reference);
+  raster[{39, 29, 19}] = 0;
+  BOOST_TEST(contentHash(raster) != reference);
+}
+
+BOOST_AUTO_TEST_CASE(thread_count_independence_test) {
+  Raster<double, 2> raster({300, 200});
+  raster.range();
+  ThreadPool serial(1);
+  ThreadPool parallel(4);
+  const ContentHash hash(raster, serial);
+  const auto bytes = raster.size() * sizeof(double);
+  BOOST_TEST(hash.chunkCount() == (bytes + ContentHash::chunkBytes - 1) / ContentHash::chunkBytes);
+  BOOST_TEST((ContentHash(raster, parallel) == hash));
+}
+
+BOOST_AUTO_TEST_CASE(incremental_update_test) {
+  Raster<float, 3> raster({100, 80, 6});
+  raster.range();
+  ContentHash hash(raster);
+  const Box<3> region({10, 70, 2}, {120, 90, 3}); // Partially outside
+  for (const auto& p : region) {
+    if (raster.contains(p)) {
+      raster[p] = -1;
+    }
+  }
+  BOOST_TEST(hash.value() != contentHash(raster));
+  hash.update(raster, region);
+  BOOST_TEST(hash.value() == contentHash(raster));
+}
+
+BOOST_AUTO_TEST_CASE(update_changed_shape_throws_test) {
+  Raster<float> raster({10, 10});
+  ContentHash hash(raster);
+  Raster<float> other({20, 5});
+  BOOST_CHECK_THROW(hash.update(other, other.domain()), Exception);
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlRaster/MemoCache.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(MemoCache_test)
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(hit_and_miss_test) {
+  Raster<int> input({10, 10});
+  input.range();
+  const auto hash = contentHash(input);
+  MemoCache<Raster<int>> cache(1 << 20);
+  int calls = 0;
+  const auto twice = [&]() {
+    ++calls;
+    return input * 2;
+  };
+  const auto first = cache.get("scale", hashValues(2), hash, twice);
+  const auto second = cache.get("scale", hashValues(2), hash, twice);
+  BOOST_TEST(calls == 1);
+  BOOST_TEST(first.get() == second.get());
+  BOOST_TEST(*first == input * 2);
+  BOOST_TEST(cache.hitCount() == 1);
+  BOOST_TEST(cache.missCount() == 1);
+  BOOST_TEST(cache.size() == 1);
+  BOOST_TEST(cache.residentBytes() >= input.size() * sizeof(int));
+  cache.get("scale", hashValues(3), hash, twice);
+  cache.get("offset", hashValues(2), hash, twice);
+  BOOST_TEST(calls == 3);
+  BOOST_TEST(cache.size() == 3);
+}
+
+BOOST_AUTO_TEST_CASE(budget_eviction_test) {
+  MemoCache<std::vector<char>> cache(250);
+  const auto make = [](std::size_t size) {
+    return [=]() {
+      return std::vector<char>(size);
+    };
+  };
+  cache.get("a", 0, 0, make(100));
+  cache.get("b", 0, 0, make(100));
+  cache.get("a", 0, 0, make(100)); // a is most recent
+  cache.get("c", 0, 0, make(100)); // b is evicted
+  BOOST_TEST(cache.contains("a", 0, 0));
+  BOOST_TEST(not cache.contains("b", 0, 0));
+  BOOST_TEST(cache.contains("c", 0, 0));
+  BOOST_TEST(cache.residentBytes() <= cache.budget());
+  const auto large = cache.get("d", 0, 0, make(1000)); // Not cached
+  BOOST_TEST(large->size() == 1000);
+  BOOST_TEST(not cache.contains("d", 0, 0));
+  cache.clear();
+  BOOST_TEST(cache.size() == 0);
+  BOOST_TEST(cache.residentBytes() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(custom_sizer_test) {
+  MemoCache<int> cache(10, [](int value) {
+    return std::size_t(value);
+  });
+  cache.get("x", 0, 0, []() {
+    return 6;
+  });
+  cache.get("y", 0, 0, []() {
+    return 5;
+  });
+  BOOST_TEST(not cache.contains("x", 0, 0));
+  BOOST_TEST(cache.residentBytes() == 5);
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
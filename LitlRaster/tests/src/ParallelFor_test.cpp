@@ -0,0 +1,183 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlRaster/ParallelFor.h"
+#include "LitlRaster/Raster.h"
+
+#include <atomic>
+#include <boost/test/unit_test.hpp>
+#include <set>
+#include <string>
+#include <thread>
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(ParallelFor_test)
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(thread_pool_runs_each_task_once_test) {
+  ThreadPool pool(4);
+  BOOST_TEST(pool.threadCount() == 4);
+  std::vector<std::atomic<int>> counts(1000);
+  pool.run(counts.size(), [&](std::size_t i) {
+    ++counts[i];
+  });
+  for (const auto& c : counts) {
+    BOOST_TEST(c == 1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_rethrows_test) {
+  ThreadPool pool(3);
+  std::atomic<int> count(0);
+  BOOST_CHECK_THROW(
+      pool.run(
+          100,
+          [&](std::size_t i) {
+            ++count;
+            if (i == 42) {
+              throw Exception("Task 42");
+            }
+          }),
+      Exception);
+  BOOST_TEST(count == 100);
+}
+
+BOOST_AUTO_TEST_CASE(sequential_run_rethrows_test) {
+  ThreadPool pool(1); // No worker
+  std::size_t count = 0;
+  std::string message;
+  try {
+    pool.run(10, [&](std::size_t i) {
+      ++count;
+      if (i % 4 == 1) {
+        throw Exception("Task " + std::to_string(i));
+      }
+    });
+  } catch (const Exception& e) {
+    message = e.what();
+  }
+  BOOST_TEST(count == 10); // The tasks after the throwing ones were run
+  BOOST_TEST(message.find("Task 1") != std::string::npos); // The first exception was rethrown
+  BOOST_TEST(message.find("Task 5") == std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_try_run_test) {
+  ThreadPool pool(2);
+  std::atomic<int> started(0);
+  std::atomic<bool> released(false);
+  std::thread other([&]() {
+    pool.run(2, [&](std::size_t) {
+      ++started;
+      while (not released) {
+        std::this_thread::yield();
+      }
+    });
+  });
+  while (started == 0) {
+    std::this_thread::yield();
+  }
+  std::atomic<int> count(0);
+  BOOST_TEST(not pool.tryRun(10, [&](std::size_t) {
+    ++count;
+  }));
+  BOOST_TEST(count == 0);
+  released = true;
+  other.join();
+  BOOST_TEST(pool.tryRun(10, [&](std::size_t) {
+    ++count;
+  }));
+  BOOST_TEST(count == 10);
+}
+
+BOOST_AUTO_TEST_CASE(partition_is_deterministic_cover_test) {
+  const Box<3> box {{1, 2, 3}, {40, 30, 20}};
+  const Index grainSize = 1000;
+  const auto grains = partition(box, grainSize);
+  BOOST_TEST(grains.size() > 1);
+  BOOST_TEST(grains.size() == partition(box, grainSize).size());
+  std::set<Indices<3>> covered;
+  Index count = 0;
+  for (const auto& g : grains) {
+    BOOST_TEST(g.size() <= grainSize);
+    for (const auto& p : g) {
+      covered.insert(p.container());
+      ++count;
+    }
+  }
+  BOOST_TEST(count == box.size());
+  BOOST_TEST(covered.size() == box.size());
+}
+
+BOOST_AUTO_TEST_CASE(partition_preserves_rows_test) {
+  const Box<2> box {{0, 0}, {99, 9}};
+  const auto grains = partition(box, 10, 1);
+  BOOST_TEST(grains.size() == 10);
+  for (const auto& g : grains) {
+    BOOST_TEST(g.length(0) == 100);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_for_each_test) {
+  ThreadPool pool(4);
+  Raster<int, 3> raster({17, 13, 11});
+  parallelForEach(
+      raster.domain(),
+      [&](const auto& p) {
+        raster[p] = p[0] + p[1] + p[2];
+      },
+      64,
+      pool);
+  for (const auto& p : raster.domain()) {
+    BOOST_TEST(raster[p] == p[0] + p[1] + p[2]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_for_each_row_test) {
+  ThreadPool pool(4);
+  Raster<int, 3> raster({17, 13, 11});
+  raster.fill(0);
+  const Box<3> box {{2, 1, 1}, {15, 11, 9}};
+  parallelForEachRow(
+      box,
+      [&](const auto& front, Index length) {
+        auto* it = &raster[front];
+        for (Index i = 0; i < length; ++i, ++it) {
+          ++*it;
+        }
+      },
+      50,
+      pool);
+  for (const auto& p : raster.domain()) {
+    const bool inside = p[0] >= 2 && p[0] <= 15 && p[1] >= 1 && p[1] <= 11 && p[2] >= 1 && p[2] <= 9;
+    BOOST_TEST(raster[p] == inside);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(nested_parallel_for_test) {
+  ThreadPool pool(4);
+  std::atomic<Index> count(0);
+  const Box<2> box {{0, 0}, {9, 9}};
+  parallelForEach(
+      box,
+      [&](const auto&) {
+        parallelForEach(
+            box,
+            [&](const auto&) {
+              ++count;
+            },
+            10,
+            pool);
+      },
+      10,
+      pool);
+  BOOST_TEST(count == 10000);
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,8 @@
 #include "LitlRaster/Raster.h"
 
 #include <boost/test/unit_test.hpp>
+#include <iterator> // distance, forward_iterator_tag, iterator_traits
+#include <type_traits> // is_same
 
 using namespace Litl;
 
@@ -37,6 +39,73 @@ BOOST_AUTO_TEST_CASE(index_test) {
   BOOST_TEST(variableIndex == fixedIndex);
 }
 
+BOOST_AUTO_TEST_CASE(strides_test) {
+  const Position<3> shape {4, 3, 5};
+  Raster<int, 3> fixed(shape);
+  Raster<int, -1> variable(Position<-1>(shape.container()));
+  BOOST_TEST(fixed.strides() == Position<3>({1, 4, 12}));
+  BOOST_TEST(variable.strides() == Position<-1>({1, 4, 12}));
+  for (const auto& p : fixed.domain()) {
+    const auto expected = Internal::IndexRecursionImpl<3>::index(shape, p);
+    BOOST_TEST(fixed.index(p) == expected);
+    BOOST_TEST(variable.index(Position<-1>(p.container())) == expected);
+  }
+  const auto copied = fixed;
+  BOOST_TEST(copied.strides() == fixed.strides());
+  BOOST_CHECK_THROW(variable.index(Position<-1>({0, 0})), SizeError);
+}
+
+BOOST_AUTO_TEST_CASE(variable_dimension_list_test) {
+  const Raster<int, -1> raster(Position<-1>({3, 2}), {1, 2, 3, 4, 5, 6});
+  BOOST_TEST(raster.size() == 6);
+  BOOST_TEST((raster[{2, 1}] == 6));
+}
+
+BOOST_AUTO_TEST_CASE(enumerate_test) {
+  Raster<int, 3> raster({6, 5, 4});
+  raster.range();
+  const Box<3> box {{1, 2, 0}, {4, 3, 2}};
+  auto it = begin(box);
+  Index count = 0;
+  for (const auto& e : raster.enumerate(box)) {
+    BOOST_TEST(e.position == *it);
+    BOOST_TEST(e.index == raster.index(*it));
+    ++it;
+    ++count;
+  }
+  BOOST_TEST(count == box.size());
+  count = 0;
+  for (const auto& e : raster.enumerate()) {
+    BOOST_TEST(raster[e.position] == e.index);
+    ++count;
+  }
+  BOOST_TEST(count == raster.size());
+}
+
+BOOST_AUTO_TEST_CASE(enumerate_outside_domain_test) {
+  const Raster<int> raster({3, 4});
+  const Box<2> box {{0, 0}, {5, 1}}; // Wider than the rows, such that indices repeat
+  auto it = begin(box);
+  Index count = 0;
+  for (const auto& e : raster.enumerate(box)) {
+    BOOST_TEST(e.position == *it);
+    ++it;
+    ++count;
+  }
+  BOOST_TEST(count == box.size());
+}
+
+BOOST_AUTO_TEST_CASE(enumeration_iterator_traits_test) {
+  const Raster<int> raster({3, 4});
+  const auto enumeration = raster.enumerate();
+  using Traits = std::iterator_traits<decltype(enumeration.begin())>;
+  using Element = Enumeration<2>::Element;
+  BOOST_TEST((std::is_same<Traits::iterator_category, std::forward_iterator_tag>::value));
+  BOOST_TEST((std::is_same<Traits::value_type, Element>::value));
+  BOOST_TEST((std::is_same<Traits::reference, const Element&>::value));
+  BOOST_TEST(std::distance(enumeration.begin(), enumeration.end()) == raster.size());
+}
+
 BOOST_AUTO_TEST_CASE(ptrraster_data_test) {
   int data[] = {0, 1, 2};
   PtrRaster<int, 1> raster({3}, data);
@@ -63,6 +132,24 @@ BOOST_AUTO_TEST_CASE(const_vecraster_data_test) {
   BOOST_TEST(cVecRaster[{0}] == 0);
 }
 
+BOOST_AUTO_TEST_CASE(adoptedraster_test) {
+  bool freed = false;
+  auto* data = static_cast<int*>(std::malloc(6 * sizeof(int)));
+  {
+    AdoptedRaster<int> raster({3, 2}, data, [&](int* p) {
+      std::free(p);
+      freed = true;
+    });
+    raster.range();
+    BOOST_TEST(raster.data() == data);
+    BOOST_TEST((raster[{2, 1}] == 5));
+    const auto sum = raster + raster; // Copy
+    BOOST_TEST(sum.data() != data);
+    BOOST_TEST((sum[{2, 1}] == 10));
+  }
+  BOOST_TEST(freed);
+}
+
 BOOST_AUTO_TEST_CASE(alignedraster_owned_and_shared_test) {
   constexpr Index width = 3;
   constexpr Index height = 4;
@@ -0,0 +1,111 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlRaster/RegionCopy.h"
+
+#include <boost/test/unit_test.hpp>
+#include <cstdint> // uint8_t
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(RegionCopy_test)
+
+//-----------------------------------------------------------------------------
+
+template <typename TIn, typename TOut>
+void checkCopied(const TIn& src, const Box<3>& srcBox, const TOut& dst, const Position<3>& dstPos, TOut expected) {
+  for (const auto& p : srcBox) {
+    const auto q = p + dstPos - srcBox.front();
+    if (src.contains(p) && dst.contains(q)) {
+      expected[q] = src[p];
+    }
+  }
+  BOOST_TEST(dst == expected);
+}
+
+BOOST_AUTO_TEST_CASE(clipped_copy_test) {
+  Raster<int, 3> src({7, 6, 5});
+  src.range(1);
+  Raster<float, 3> dst({5, 6, 7});
+  dst.fill(-1);
+  const auto expected = dst;
+  const Box<3> srcBox({-2, 1, 2}, {4, 8, 3});
+  const Position<3> dstPos {2, -1, 5};
+  copyRegion(src, srcBox, dst, dstPos);
+  checkCopied(src, srcBox, dst, dstPos, expected);
+}
+
+BOOST_AUTO_TEST_CASE(disjoint_copy_test) {
+  Raster<int, 3> src({4, 4, 4});
+  src.range();
+  Raster<int, 3> dst({4, 4, 4});
+  const auto expected = dst;
+  copyRegion(src, src.domain(), dst, {0, 10, 0});
+  BOOST_TEST(dst == expected);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_copy_test) {
+  Raster<double, 3> src({100, 80, 10});
+  src.range();
+  Raster<double, 3> dst({120, 70, 12});
+  const auto expected = dst;
+  const auto srcBox = src.domain();
+  const Position<3> dstPos {10, 5, 1};
+  copyRegion(src, srcBox, dst, dstPos);
+  checkCopied(src, srcBox, dst, dstPos, expected);
+}
+
+BOOST_AUTO_TEST_CASE(overlapping_copy_test) {
+  Raster<int, 3> raster({60, 50, 8});
+  raster.range();
+  const auto expected = raster;
+  const Box<3> srcBox({0, 0, 0}, {49, 39, 6});
+  for (const auto& dstPos : {Position<3> {3, 2, 1}, Position<3> {0, 0, 0}}) {
+    raster = expected;
+    copyRegion(raster, srcBox, raster, dstPos); // Large enough to be parallel
+    checkCopied(expected, srcBox, raster, dstPos, expected);
+  }
+  Raster<int> row({10, 1});
+  row.range();
+  addRegion(row, row.domain(), row, {1, 0});
+  BOOST_TEST(row == Raster<int>({10, 1}, {0, 1, 3, 5, 7, 9, 11, 13, 15, 17}));
+}
+
+BOOST_AUTO_TEST_CASE(add_and_blend_test) {
+  Raster<float> stamp({3, 3});
+  stamp.fill(1);
+  Raster<float> mosaic({4, 4});
+  addRegion(stamp, stamp.domain(), mosaic, {-1, -1}, 2.F);
+  addRegion(stamp, stamp.domain(), mosaic, {0, 0});
+  BOOST_TEST((mosaic[{0, 0}] == 3));
+  BOOST_TEST((mosaic[{1, 1}] == 3));
+  BOOST_TEST((mosaic[{2, 2}] == 1));
+  BOOST_TEST((mosaic[{3, 3}] == 0));
+  blendRegion(stamp, stamp.domain(), mosaic, {1, 1}, .25F);
+  BOOST_TEST((mosaic[{0, 0}] == 3));
+  BOOST_TEST((mosaic[{1, 1}] == 2.5));
+  BOOST_TEST((mosaic[{2, 2}] == 1));
+  BOOST_TEST((mosaic[{3, 3}] == .25));
+}
+
+BOOST_AUTO_TEST_CASE(integral_blend_test) {
+  Raster<std::uint8_t> stamp({3, 1});
+  stamp.fill(255);
+  Raster<std::uint8_t> mosaic({3, 1});
+  mosaic.fill(10);
+  blendRegion(stamp, stamp.domain(), mosaic, {0, 0}, .25);
+  BOOST_TEST((mosaic[{0, 0}] == 71)); // 71.25
+  blendRegion(stamp, stamp.domain(), mosaic, {0, 0}, .5);
+  BOOST_TEST((mosaic[{1, 0}] == 163)); // 163
+  Raster<int> wide({1, 1});
+  wide.fill(1000);
+  blendRegion(wide, wide.domain(), mosaic, {2, 0}, 1.);
+  BOOST_TEST((mosaic[{2, 0}] == 255)); // Saturated
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
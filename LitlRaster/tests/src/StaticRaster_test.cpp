@@ -0,0 +1,60 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlRaster/StaticRaster.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(StaticRaster_test)
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(compile_time_shape_test) {
+  using Stamp = StaticRaster<float, 4, 3, 2>;
+  static_assert(Stamp::Dimension == 3, "Dimension");
+  static_assert(Stamp::Size == 24, "Size");
+  static_assert(Stamp::length<1>() == 3, "Length");
+  static_assert(Stamp::stride<2>() == 12, "Stride");
+  static_assert(sizeof(Stamp) == sizeof(float) * 24 + sizeof(void*), "Inline storage"); // + vptr of DataContainer
+  BOOST_TEST(Stamp::shape() == Position<3>({4, 3, 2}));
+  BOOST_TEST(Stamp::domain().size() == 24);
+}
+
+BOOST_AUTO_TEST_CASE(index_matches_raster_test) {
+  StaticRaster<int, 5, 4, 3> stamp;
+  stamp.range();
+  Raster<int, 3> raster(stamp.shape());
+  raster.range();
+  for (const auto& p : stamp.domain()) {
+    BOOST_TEST(stamp.index(p) == raster.index(p));
+    BOOST_TEST(stamp[p] == raster[p]);
+  }
+  BOOST_TEST(stamp.view() == raster);
+}
+
+BOOST_AUTO_TEST_CASE(list_and_arithmetic_test) {
+  const StaticRaster<int, 3, 2> a {1, 2, 3, 4, 5, 6};
+  const StaticRaster<int, 3, 2> b {6, 5, 4, 3, 2, 1};
+  const auto c = a + b;
+  for (const auto& v : c) {
+    BOOST_TEST(v == 7);
+  }
+  BOOST_TEST((a[{2, 1}] == 6));
+  BOOST_CHECK_THROW((StaticRaster<int, 3, 2> {1, 2, 3}), SizeError);
+}
+
+BOOST_AUTO_TEST_CASE(contains_test) {
+  using Stamp = StaticRaster<char, 3, 3>;
+  BOOST_TEST(Stamp::contains(Position<2> {0, 2}));
+  BOOST_TEST(not Stamp::contains(Position<2> {3, 0}));
+  BOOST_TEST(not Stamp::contains(Position<2> {0, -1}));
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -56,6 +56,11 @@ public:
    */
   Duration iterateOverPositionsOptimized();
 
+  /**
+   * @brief Loop over positions and indices via an enumeration.
+   */
+  Duration iterateOverEnumeration();
+
   /**
    * @brief Loop over indices.
    */
@@ -64,6 +64,16 @@ IterationBenchmark::Duration IterationBenchmark::iterateOverPositionsOptimized()
   return m_chrono.stop();
 }
 
+IterationBenchmark::Duration IterationBenchmark::iterateOverEnumeration() {
+  m_chrono.start();
+  //! [enumeration]
+  for (const auto& e : m_c.enumerate()) {
+    m_c[e.index] = m_a[e.index] + m_b[e.index];
+  }
+  //! [enumeration]
+  return m_chrono.stop();
+}
+
 IterationBenchmark::Duration IterationBenchmark::loopOverIndices() {
   m_chrono.start();
   //! [index]
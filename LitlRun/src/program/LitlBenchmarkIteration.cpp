@@ -21,6 +21,8 @@ Litl::IterationBenchmark::Duration iterate(Litl::IterationBenchmark& benchmark,
       return benchmark.iterateOverPositions();
     case 'q':
       return benchmark.iterateOverPositionsOptimized();
+    case 'e':
+      return benchmark.iterateOverEnumeration();
     case 'i':
       return benchmark.loopOverIndices();
     case 'v':
@@ -42,7 +44,7 @@ public:
     options.named<char>(
         "case",
         "Initial of the test case to be benchmarked: "
-        "x (x-y-z), z (z-y-x), p (position), i (index), v (value), o (operator), g (generate)");
+        "x (x-y-z), z (z-y-x), p (position), e (enumeration), i (index), v (value), o (operator), g (generate)");
     options.named<long>("side", "Image width, height and depth (same value)", 400);
     return options.asPair();
   }
@@ -51,6 +51,11 @@ BOOST_AUTO_TEST_CASE(position_optimized_test) {
   validate();
 }
 
+BOOST_AUTO_TEST_CASE(enumeration_test) {
+  iterateOverEnumeration();
+  validate();
+}
+
 BOOST_AUTO_TEST_CASE(index_test) {
   loopOverIndices();
   validate();
@@ -0,0 +1,389 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLTRANSFORMS_BLOCKCORRELATION_H
+#define _LITLTRANSFORMS_BLOCKCORRELATION_H
+
+#include "LitlTypes/TypeUtils.h"
+
+#include <algorithm> // copy, fill, max, min
+#include <cmath> // abs, ldexp, round
+#include <cstdint> // int16_t, int32_t, int64_t
+#include <limits> // numeric_limits
+#include <type_traits> // conditional, is_integral
+#include <utility> // index_sequence
+
+namespace Litl {
+
+/// @cond INTERNAL
+namespace Internal {
+
+/**
+ * @brief The default accumulator type of a kernel value type.
+ */
+template <typename T>
+using DefaultAccumulator = std::conditional_t<std::is_integral<T>::value, typename TypeTraits<T>::Accumulator, T>;
+
+/**
+ * @brief Cast a value which does not need rounding.
+ */
+template <typename TOut, typename TIn>
+TOut castKernelOutput(TIn value, std::false_type) {
+  return static_cast<TOut>(value);
+}
+
+/**
+ * @brief Round a floating point value to nearest and saturate it to the range of an integral type.
+ */
+template <typename TOut, typename TIn>
+TOut castKernelOutput(TIn value, std::true_type) {
+  const auto rounded = std::round(value);
+  if (rounded <= TIn(std::numeric_limits<TOut>::lowest())) {
+    return std::numeric_limits<TOut>::lowest();
+  }
+  if (rounded >= TIn(std::numeric_limits<TOut>::max())) {
+    return std::numeric_limits<TOut>::max();
+  }
+  return static_cast<TOut>(rounded);
+}
+
+/**
+ * @brief Convert a floating point or complex correlation result to the output type.
+ * @details
+ * This is the conversion policy of all the kernel backends:
+ * floating point values are rounded to nearest and saturated for integral outputs, and cast otherwise.
+ */
+template <typename TOut, typename TIn>
+TOut castKernelOutput(TIn value) {
+  using IsRounded = std::integral_constant<bool, std::is_floating_point<TIn>::value && std::is_integral<TOut>::value>;
+  return castKernelOutput<TOut>(value, IsRounded());
+}
+
+/**
+ * @brief Register-blocked correlation of rows.
+ * @tparam T The kernel value type
+ * @tparam TAccumulator The accumulator type
+ * @details
+ * Blocks of `Width` adjacent outputs are computed at once:
+ * for each kernel coefficient, which is broadcast, a contiguous run of input values is loaded
+ * and multiplied-added into `Width` independent accumulators, which the compiler keeps in SIMD registers.
+ * Compared to one inner product per output, each input value is loaded once per block and coefficient
+ * instead of once per output and coefficient, and the accumulations do not depend on each other.
+ *
+ * Values are accumulated as `T` for floating point and complex types, such that the SIMD width is not reduced,
+ * and FMA instructions are used when enabled; integers are accumulated as `TypeTraits<T>::Accumulator`,
+ * i.e. 64 bits, such that intermediate sums do not overflow, unless a narrower accumulator is provided
+ * (see `withIntegerAccumulator()`).
+ * Integral sums can be divided by a power of two, rounded to nearest, for fixed-point kernels,
+ * and are saturated to the range of integral outputs;
+ * floating point sums are converted with `castKernelOutput()`, like with the other kernel backends.
+ *
+ * Small kernels which are common for derivation and smoothing, i.e. 3, 5, 3x3, 5x5 and 3x3x3 kernels,
+ * are dispatched to `applyFixed()`, where the kernel shape is a compile-time constant.
+ */
+template <typename T, typename TAccumulator = DefaultAccumulator<T>>
+struct BlockCorrelation {
+
+  /**
+   * @brief The accumulator type.
+   */
+  using Accumulator = TAccumulator;
+
+  /**
+   * @brief The number of outputs per block, such that the accumulators fill several SIMD registers without spilling.
+   */
+  static constexpr Index Width = std::max<Index>(std::min<Index>(256 / sizeof(Accumulator), 32), 4);
+
+  /**
+   * @brief Correlate a row.
+   * @param kernel The kernel values, of size `kWidth * kRowCount`
+   * @param kWidth The kernel length along axis 0
+   * @param rowOffsets The offsets of the kernel rows in the input data
+   * @param kRowCount The number of kernel rows
+   * @param in The input data which corresponds to the front of the window of the first output
+   * @param width The number of outputs
+   * @param out The output row
+   * @param shift The number of fractional bits of integral kernels
+   * @param bias The initial value of the sums
+   */
+  template <typename TIn, typename TOut>
+  static void apply(
+      const T* kernel,
+      Index kWidth,
+      const Index* rowOffsets,
+      Index kRowCount,
+      const TIn* in,
+      Index width,
+      TOut* out,
+      Index shift = 0,
+      Accumulator bias = Accumulator()) {
+    if (kWidth == 3 && kRowCount == 1) {
+      return applyFixed<3, 1>(kernel, rowOffsets, in, width, out, shift, bias);
+    }
+    if (kWidth == 5 && kRowCount == 1) {
+      return applyFixed<5, 1>(kernel, rowOffsets, in, width, out, shift, bias);
+    }
+    if (kWidth == 3 && kRowCount == 3) {
+      return applyFixed<3, 3>(kernel, rowOffsets, in, width, out, shift, bias);
+    }
+    if (kWidth == 5 && kRowCount == 5) {
+      return applyFixed<5, 5>(kernel, rowOffsets, in, width, out, shift, bias);
+    }
+    if (kWidth == 3 && kRowCount == 9) {
+      return applyFixed<3, 9>(kernel, rowOffsets, in, width, out, shift, bias);
+    }
+    Index i = 0;
+    for (; i + Width <= width; i += Width) {
+      Accumulator sums[Width];
+      std::fill(sums, sums + Width, bias);
+      const T* kIt = kernel;
+      for (Index r = 0; r < kRowCount; ++r) {
+        const TIn* row = in + rowOffsets[r] + i;
+        for (Index j = 0; j < kWidth; ++j, ++kIt) {
+          const Accumulator k = *kIt;
+          for (Index b = 0; b < Width; ++b) {
+            sums[b] += k * Accumulator(row[j + b]);
+          }
+        }
+      }
+      for (Index b = 0; b < Width; ++b) {
+        store(sums[b], shift, out[i + b]);
+      }
+    }
+    for (; i < width; ++i) {
+      Accumulator sum = bias;
+      const T* kIt = kernel;
+      for (Index r = 0; r < kRowCount; ++r) {
+        const TIn* row = in + rowOffsets[r] + i;
+        for (Index j = 0; j < kWidth; ++j, ++kIt) {
+          sum += Accumulator(*kIt) * Accumulator(row[j]);
+        }
+      }
+      store(sum, shift, out[i]);
+    }
+  }
+
+  /**
+   * @brief Correlate a row with a kernel of fixed shape.
+   * @tparam KWidth The kernel length along axis 0
+   * @tparam KRowCount The number of kernel rows
+   * @details
+   * The kernel values are copied to a local array, and the loops over the kernel values are unrolled at compile time,
+   * such that the kernel is kept in registers and each kernel row is applied to a block of outputs
+   * as a single vectorized loop.
+   */
+  template <Index KWidth, Index KRowCount, typename TIn, typename TOut>
+  static void applyFixed(
+      const T* kernel,
+      const Index* rowOffsets,
+      const TIn* in,
+      Index width,
+      TOut* out,
+      Index shift = 0,
+      Accumulator bias = Accumulator()) {
+    using Taps = std::make_index_sequence<KWidth>;
+    Accumulator k[KWidth * KRowCount];
+    std::copy(kernel, kernel + KWidth * KRowCount, k);
+    Index i = 0;
+    for (; i + Width <= width; i += Width) {
+      Accumulator sums[Width];
+      std::fill(sums, sums + Width, bias);
+      for (Index r = 0; r < KRowCount; ++r) {
+        const TIn* row = in + rowOffsets[r] + i;
+        const Accumulator* c = k + r * KWidth;
+        for (Index b = 0; b < Width; ++b) {
+          sums[b] += fixedSum(c, row + b, Taps());
+        }
+      }
+      for (Index b = 0; b < Width; ++b) {
+        store(sums[b], shift, out[i + b]);
+      }
+    }
+    for (; i < width; ++i) {
+      Accumulator sum = bias;
+      for (Index r = 0; r < KRowCount; ++r) {
+        sum += fixedSum(k + r * KWidth, in + rowOffsets[r] + i, Taps());
+      }
+      store(sum, shift, out[i]);
+    }
+  }
+
+  /**
+   * @brief Correlate interleaved lines along their common axis.
+   * @param kernel The kernel values
+   * @param kSize The kernel size
+   * @param in The input data which corresponds to the front of the window of the first line
+   * @param stride The offset between consecutive values of a line
+   * @param width The number of lines, which are contiguous in memory
+   * @param out The output value of the first line
+   * @param shift The number of fractional bits of integral kernels
+   * @param bias The initial value of the sums
+   * @details
+   * One output of each line is computed, i.e. `width` contiguous outputs,
+   * as the weighted sum of `kSize` contiguous slices of `width` input values.
+   * Blocks of `Width` lines are correlated at once, such that the memory is accessed with unit stride only:
+   * for each kernel coefficient, which is broadcast, a block of input values is multiplied-added
+   * into `Width` independent accumulators, like with `apply()`.
+   */
+  template <typename TIn, typename TOut>
+  static void applyInterleaved(
+      const T* kernel,
+      Index kSize,
+      const TIn* in,
+      Index stride,
+      Index width,
+      TOut* out,
+      Index shift = 0,
+      Accumulator bias = Accumulator()) {
+    Index l = 0;
+    for (; l + Width <= width; l += Width) {
+      Accumulator sums[Width];
+      std::fill(sums, sums + Width, bias);
+      const TIn* slice = in + l;
+      for (Index k = 0; k < kSize; ++k, slice += stride) {
+        const Accumulator c = kernel[k];
+        for (Index b = 0; b < Width; ++b) {
+          sums[b] += c * Accumulator(slice[b]);
+        }
+      }
+      for (Index b = 0; b < Width; ++b) {
+        store(sums[b], shift, out[l + b]);
+      }
+    }
+    for (; l < width; ++l) {
+      Accumulator sum = bias;
+      const TIn* slice = in + l;
+      for (Index k = 0; k < kSize; ++k, slice += stride) {
+        sum += Accumulator(kernel[k]) * Accumulator(*slice);
+      }
+      store(sum, shift, out[l]);
+    }
+  }
+
+  /**
+   * @brief Compute the weighted sum of a fixed number of contiguous values, with an unrolled loop.
+   */
+  template <typename TIn, std::size_t... Js>
+  static Accumulator fixedSum(const Accumulator* k, const TIn* row, std::index_sequence<Js...>) {
+    Accumulator sum {};
+    using Expand = int[];
+    (void)Expand {0, (sum += k[Js] * Accumulator(row[Js]), 0)...};
+    return sum;
+  }
+
+  /**
+   * @brief Convert a sum to an output value.
+   * @param sum The sum
+   * @param shift The number of fractional bits of integral kernels
+   * @param out The output value
+   */
+  template <typename TOut>
+  static void store(Accumulator sum, Index shift, TOut& out) {
+    store(
+        sum,
+        shift,
+        out,
+        std::integral_constant<bool, std::is_integral<Accumulator>::value>(),
+        std::integral_constant<bool, std::is_integral<Accumulator>::value && std::is_integral<TOut>::value>());
+  }
+
+  /**
+   * @brief Convert a floating point or complex sum.
+   */
+  template <typename TOut>
+  static void store(Accumulator sum, Index, TOut& out, std::false_type, std::false_type) {
+    out = castKernelOutput<TOut>(sum);
+  }
+
+  /**
+   * @brief Round an integral sum to a non-integral output.
+   */
+  template <typename TOut>
+  static void store(Accumulator sum, Index shift, TOut& out, std::true_type, std::false_type) {
+    out = static_cast<TOut>(roundShift(sum, shift));
+  }
+
+  /**
+   * @brief Round and saturate an integral sum to an integral output.
+   */
+  template <typename TOut>
+  static void store(Accumulator sum, Index shift, TOut& out, std::true_type, std::true_type) {
+    out = saturate<TOut>(roundShift(sum, shift));
+  }
+
+  /**
+   * @brief Divide an integral sum by `2^shift`, rounded to nearest, with ties rounded up.
+   */
+  static Accumulator roundShift(Accumulator sum, Index shift) {
+    return shift > 0 ? Accumulator((sum + (Accumulator(1) << (shift - 1))) >> shift) : sum;
+  }
+
+  /**
+   * @brief Clamp an integral value to the range of an integral type.
+   */
+  template <typename TOut>
+  static TOut saturate(Accumulator value) {
+    constexpr auto lowest = std::numeric_limits<TOut>::lowest();
+    constexpr auto highest = std::numeric_limits<TOut>::max();
+    if (std::is_signed<Accumulator>::value && value < Accumulator()) {
+      return std::is_unsigned<TOut>::value || std::int64_t(value) < std::int64_t(lowest) ? lowest : TOut(value);
+    }
+    return std::uint64_t(value) > std::uint64_t(highest) ? highest : TOut(value);
+  }
+};
+
+/**
+ * @brief Call a function with the default accumulator.
+ */
+template <typename TIn, typename T, typename TFunc>
+void withIntegerAccumulator(const T*, std::size_t, Index, TFunc&& func, std::false_type) {
+  func(DefaultAccumulator<T>());
+}
+
+/**
+ * @brief Call a function with a 16-bit, 32-bit or default accumulator.
+ */
+template <typename TIn, typename T, typename TFunc>
+void withIntegerAccumulator(const T* kernel, std::size_t size, Index shift, TFunc&& func, std::true_type) {
+  double norm = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    norm += std::abs(double(kernel[i]));
+  }
+  const auto in = std::max(-double(std::numeric_limits<TIn>::lowest()), double(std::numeric_limits<TIn>::max()));
+  const auto bound = norm * in + (shift > 0 ? std::ldexp(1., int(shift) - 1) : 0.);
+  if (bound <= std::numeric_limits<std::int16_t>::max()) {
+    func(std::int16_t());
+  } else if (bound <= std::numeric_limits<std::int32_t>::max()) {
+    func(std::int32_t());
+  } else {
+    func(DefaultAccumulator<T>());
+  }
+}
+
+/**
+ * @brief Call a function with a value of the narrowest accumulator type which cannot overflow.
+ * @param kernel The kernel values
+ * @param size The number of kernel values
+ * @param shift The number of fractional bits
+ * @param func The function, which takes a value of the accumulator type
+ * @details
+ * For integral kernels and inputs of at most 16 bits, the sum of the absolute kernel values
+ * times the largest absolute input value, plus the rounding term, bounds the magnitude of any partial sum.
+ * If it fits in 16 bits, e.g. for 8-bit inputs and small smoothing or derivation kernels, or in 32 bits,
+ * the accumulator is narrowed accordingly, such that more values are processed per SIMD instruction.
+ * Otherwise, `DefaultAccumulator<T>` is used.
+ */
+template <typename TIn, typename T, typename TFunc>
+void withIntegerAccumulator(const T* kernel, std::size_t size, Index shift, TFunc&& func) {
+  using IsNarrowable =
+      std::integral_constant<bool, std::is_integral<T>::value && std::is_integral<TIn>::value && sizeof(TIn) <= 2>;
+  withIntegerAccumulator<TIn>(kernel, size, shift, std::forward<TFunc>(func), IsNarrowable());
+}
+
+} // namespace Internal
+/// @endcond
+
+} // namespace Litl
+
+#endif
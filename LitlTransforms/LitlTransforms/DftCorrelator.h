@@ -0,0 +1,244 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLTRANSFORMS_DFTCORRELATOR_H
+#define _LITLTRANSFORMS_DFTCORRELATOR_H
+
+#include "LitlTransforms/KernelBackend.h"
+
+#include <complex>
+#include <mutex>
+#include <type_traits> // is_arithmetic
+#include <vector>
+
+namespace Litl {
+
+/**
+ * @ingroup dft
+ * @brief Correlator in the Fourier domain which prepares the kernel spectrum once per input shape.
+ * @tparam T The kernel value type
+ * @tparam N The dimension
+ * @details
+ * The first correlation of an input of a given shape plans a pair of `RealDft`s
+ * and computes the spectrum of the kernel, which are then kept for the following inputs of the same shape,
+ * such that each of them costs a single forward and a single inverse transform.
+ * This is the method of choice to apply the same PSF or matched filter to a stream of frames.
+ *
+ * The input is padded with the extrapolated values over the window extended to the origin,
+ * and then zero-padded to a shape whose lengths are products of 2, 3, 5 and 7.
+ * The kernel spectrum only depends on this shape,
+ * such that inputs with different extrapolation methods share the same plans.
+ *
+ * Results are the same as `Kernel` correlation up to floating point rounding errors,
+ * and integral outputs are rounded to nearest.
+ * A correlator owns buffers and must not be shared between threads;
+ * the tiled correlation of `Kernel` is preferred for single very large inputs.
+ *
+ * \par_example
+ * \code
+ * DftCorrelator<float> correlator(psf);
+ * for (const auto& frame : frames) {
+ *   const auto blurred = correlator * extrapolate<NearestNeighbor>(frame); // Two transforms per frame
+ *   ...
+ * }
+ * \endcode
+ */
+template <typename T, Index N = 2>
+class DftCorrelator {
+  static_assert(std::is_arithmetic<T>::value, "DFT correlation requires real kernels.");
+
+public:
+  /**
+   * @brief The kernel value type.
+   */
+  using Value = T;
+
+  /**
+   * @brief The dimension parameter.
+   */
+  static constexpr Index Dimension = N;
+
+  /// @{
+  /// @group_construction
+
+  /**
+   * @brief Constructor.
+   * @param values The kernel values
+   * @param window The kernel window
+   */
+  DftCorrelator(const T* values, Box<N> window) :
+      m_values(values, values + window.size()), m_window(std::move(window)),
+      m_margin(Internal::paddingMargin(m_window)), m_plans() {}
+
+  /**
+   * @brief Make a correlator from a kernel, e.g. a `Kernel`.
+   */
+  template <typename TKernel>
+  explicit DftCorrelator(const TKernel& kernel) : DftCorrelator(kernel.raster().data(), kernel.window()) {}
+
+  LITL_NON_COPYABLE(DftCorrelator)
+
+  /**
+   * @brief Move constructor.
+   */
+  DftCorrelator(DftCorrelator&&) = default;
+
+  /**
+   * @brief Move assignment.
+   * @details
+   * The plans of this correlator are destroyed first.
+   */
+  DftCorrelator& operator=(DftCorrelator&& other) {
+    if (this != &other) {
+      clear();
+      m_values = std::move(other.m_values);
+      m_window = std::move(other.m_window);
+      m_margin = std::move(other.m_margin);
+      m_plans = std::move(other.m_plans);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Destructor.
+   */
+  ~DftCorrelator() = default;
+
+  /// @group_properties
+
+  /**
+   * @brief Get the kernel window.
+   */
+  const Box<N>& window() const {
+    return m_window;
+  }
+
+  /**
+   * @brief Get the shape of the transforms for a given input shape.
+   */
+  Position<N> dftShape(const Position<N>& shape) const {
+    auto out = shape;
+    for (std::size_t i = 0; i < out.size(); ++i) {
+      out[i] = Internal::fastDftLength(shape[i] + m_margin.length(i) - 1);
+    }
+    return out;
+  }
+
+  /**
+   * @brief Get the number of prepared transform shapes.
+   */
+  std::size_t planCount() const {
+    return m_plans.size();
+  }
+
+  /// @group_operations
+
+  /**
+   * @brief Cross-correlate a raster with the kernel.
+   */
+  template <typename TRaster, typename TMethod>
+  Raster<Value, Dimension> operator*(const Extrapolator<TRaster, TMethod>& in) {
+    Raster<Value, Dimension> out(in.shape());
+    correlateTo(in, out);
+    return out;
+  }
+
+  /**
+   * @copybrief operator*()
+   * @param in The input extrapolator
+   * @param out The output raster
+   */
+  template <typename TRaster, typename TMethod, typename TOut>
+  void correlateTo(const Extrapolator<TRaster, TMethod>& in, TOut& out) {
+    const auto& shape = in.shape();
+    if (shapeSize(shape) == 0) {
+      return;
+    }
+    auto& plans = prepare(dftShape(shape));
+    auto& signal = plans.dft->in();
+    signal.fill(0);
+    const auto inputBox = in.domain() + m_margin;
+    Internal::extrapolateRegion(in, inputBox, signal);
+    Internal::dftCorrelateSpectrum(*plans.dft, *plans.idft, plans.spectrum.data());
+    const auto front = -m_margin.front();
+    Internal::copyKernelOutput(plans.idft->out(), Box<N>(front, front + shape - 1), out);
+  }
+
+  /// @group_modifiers
+
+  /**
+   * @brief Destroy the plans and spectra.
+   */
+  void clear() {
+    m_plans.clear(); // Plans lock the planner at destruction
+  }
+
+  /// @}
+
+private:
+  /**
+   * @brief The plans and kernel spectrum of a transform shape.
+   */
+  struct Plans {
+
+    /**
+     * @brief The forward plan, which owns the buffers.
+     */
+    Internal::LockedPlanPtr<RealDft<N>> dft;
+
+    /**
+     * @brief The inverse plan.
+     */
+    Internal::LockedPlanPtr<typename RealDft<N>::Inverse> idft;
+
+    /**
+     * @brief The kernel spectrum.
+     */
+    std::vector<std::complex<double>> spectrum;
+  };
+
+  /**
+   * @brief Get the plans of a transform shape, creating them if needed.
+   */
+  Plans& prepare(const Position<N>& shape) {
+    for (auto& p : m_plans) {
+      if (p.dft->logicalShape() == shape) {
+        return p;
+      }
+    }
+    Plans plans;
+    {
+      std::lock_guard<std::mutex> lock(Internal::dftPlannerMutex());
+      plans.dft.reset(new RealDft<N>(shape));
+      plans.idft.reset(new typename RealDft<N>::Inverse(plans.dft->inverse()));
+    }
+    plans.spectrum = Internal::dftKernelSpectrum(m_values.data(), m_window, *plans.dft);
+    m_plans.push_back(std::move(plans));
+    return m_plans.back();
+  }
+
+  /**
+   * @brief The kernel values.
+   */
+  std::vector<T> m_values;
+
+  /**
+   * @brief The kernel window.
+   */
+  Box<N> m_window;
+
+  /**
+   * @brief The padding margin.
+   */
+  Box<N> m_margin;
+
+  /**
+   * @brief The prepared transforms.
+   */
+  std::vector<Plans> m_plans;
+};
+
+} // namespace Litl
+
+#endif
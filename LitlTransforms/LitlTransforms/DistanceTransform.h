@@ -0,0 +1,343 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLTRANSFORMS_DISTANCETRANSFORM_H
+#define _LITLTRANSFORMS_DISTANCETRANSFORM_H
+
+#include "LitlContainer/Workspace.h"
+#include "LitlRaster/ParallelFor.h"
+#include "LitlRaster/Raster.h"
+
+#include <algorithm> // max, min
+#include <cmath> // abs, floor, sqrt
+#include <limits>
+
+namespace Litl {
+
+/// @cond INTERNAL
+namespace Internal {
+
+/**
+ * @brief The per-line distance transforms.
+ * @tparam P The norm: 1, 2 or -1 for L∞
+ * @details
+ * Each method transforms the line `f` in place, where `f` is the distance of each pixel to the nearest feature
+ * along the previous axes (squared for L2), or infinity.
+ * The envelope-based methods follow Meijster et al., "A General Algorithm for Computing Distance Transforms
+ * in Linear Time" (2000), with the lower envelope of Felzenszwalb and Huttenlocher in the L2 case.
+ */
+template <Index P>
+struct LineDistance;
+
+/**
+ * @brief Lower-envelope algorithm, parametrized by the distance function and separator.
+ */
+template <typename TDist>
+struct LineEnvelope {
+
+  /**
+   * @brief Transform a line.
+   * @param f The input and output distances
+   * @param nearest The input and output nearest features, or `nullptr`
+   * @param length The line length
+   * @param s Buffer for the envelope indices, of size `length`
+   * @param t Buffer for the envelope starts, of size `length`
+   * @param g Buffer for the input values, of size `length`
+   * @param k Buffer for the input nearest features, of size `length`, or `nullptr` if `nearest` is
+   */
+  static void apply(double* f, Index* nearest, Index length, Index* s, Index* t, double* g, Index* k) {
+    Index q = -1;
+    for (Index u = 0; u < length; ++u) {
+      g[u] = f[u];
+      if (nearest) {
+        k[u] = nearest[u];
+      }
+      if (g[u] == std::numeric_limits<double>::infinity()) {
+        continue;
+      }
+      while (q >= 0 && TDist::f(t[q], s[q], g) > TDist::f(t[q], u, g)) {
+        --q;
+      }
+      if (q < 0) {
+        q = 0;
+        s[0] = u;
+        t[0] = 0;
+      } else {
+        const auto w = 1 + TDist::sep(s[q], u, g);
+        if (w < length) {
+          ++q;
+          s[q] = u;
+          t[q] = w;
+        }
+      }
+    }
+    if (q < 0) { // No feature
+      return;
+    }
+    for (Index x = length - 1; x >= 0; --x) {
+      f[x] = TDist::f(x, s[q], g);
+      if (nearest) {
+        nearest[x] = k[s[q]];
+      }
+      if (x == t[q]) {
+        --q;
+      }
+    }
+  }
+};
+
+/**
+ * @brief L2 distance, as squared distance.
+ */
+template <>
+struct LineDistance<2> {
+
+  /**
+   * @brief The squared distance to feature `i` at `x`.
+   */
+  static double f(Index x, Index i, const double* g) {
+    const double d = x - i;
+    return d * d + g[i];
+  }
+
+  /**
+   * @brief The last position which is closer to `i` than to `u`, for `i < u`.
+   */
+  static Index sep(Index i, Index u, const double* g) {
+    return Index(std::floor((double(u) * u - double(i) * i + g[u] - g[i]) / (2. * (u - i))));
+  }
+
+  /**
+   * @brief Transform a line.
+   */
+  template <typename... TArgs>
+  static void apply(TArgs&&... args) {
+    LineEnvelope<LineDistance<2>>::apply(std::forward<TArgs>(args)...);
+  }
+
+  /**
+   * @brief Get the distance from the accumulated value.
+   */
+  static double finalize(double value) {
+    return std::sqrt(value);
+  }
+};
+
+/**
+ * @brief L∞ distance.
+ */
+template <>
+struct LineDistance<-1> {
+
+  /**
+   * @brief The distance to feature `i` at `x`.
+   */
+  static double f(Index x, Index i, const double* g) {
+    return std::max(double(std::abs(x - i)), g[i]);
+  }
+
+  /**
+   * @brief The last position which is closer to `i` than to `u`, for `i < u`.
+   */
+  static Index sep(Index i, Index u, const double* g) {
+    const auto gi = Index(g[i]);
+    const auto gu = Index(g[u]);
+    if (gi <= gu) {
+      return std::max(i + gu, (i + u) / 2);
+    }
+    return std::min(u - gi, (i + u) / 2);
+  }
+
+  /**
+   * @brief Transform a line.
+   */
+  template <typename... TArgs>
+  static void apply(TArgs&&... args) {
+    LineEnvelope<LineDistance<-1>>::apply(std::forward<TArgs>(args)...);
+  }
+
+  /**
+   * @brief Get the distance from the accumulated value.
+   */
+  static double finalize(double value) {
+    return value;
+  }
+};
+
+/**
+ * @brief L1 distance.
+ */
+template <>
+struct LineDistance<1> {
+
+  /**
+   * @brief Transform a line with a forward and a backward running pass.
+   */
+  static void apply(double* f, Index* nearest, Index length, Index*, Index*, double*, Index*) {
+    for (Index x = 1; x < length; ++x) {
+      if (f[x - 1] + 1 < f[x]) {
+        f[x] = f[x - 1] + 1;
+        if (nearest) {
+          nearest[x] = nearest[x - 1];
+        }
+      }
+    }
+    for (Index x = length - 2; x >= 0; --x) {
+      if (f[x + 1] + 1 < f[x]) {
+        f[x] = f[x + 1] + 1;
+        if (nearest) {
+          nearest[x] = nearest[x + 1];
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Get the distance from the accumulated value.
+   */
+  static double finalize(double value) {
+    return value;
+  }
+};
+
+/**
+ * @brief Compute a distance transform, and optionally the nearest features.
+ */
+template <Index P, typename TIn, typename TPredicate>
+Raster<double, TIn::Dimension>
+distanceTransformImpl(const TIn& in, TPredicate&& predicate, Raster<Index, TIn::Dimension>* nearest, ThreadPool& pool) {
+  static constexpr Index N = TIn::Dimension;
+  Raster<double, N> out(in.shape());
+  if (nearest) {
+    *nearest = Raster<Index, N>(in.shape());
+  }
+  const auto size = Index(out.size());
+  auto* d = out.data();
+  auto* k = nearest ? nearest->data() : nullptr;
+  for (Index i = 0; i < size; ++i) {
+    const bool isFeature = predicate(in[i]);
+    d[i] = isFeature ? 0 : std::numeric_limits<double>::infinity();
+    if (k) {
+      k[i] = isFeature ? i : -1;
+    }
+  }
+
+  // Separable passes, parallelized over the lines
+  const auto domain = out.domain();
+  for (Index a = 0; a < out.dimension(); ++a) {
+    const auto length = out.length(a);
+    const auto stride = out.stride(a);
+    parallelForEachGrain(
+        project(domain, a),
+        [&](const Box<N>& grain) {
+          auto& workspace = Workspace::local();
+          auto* line = workspace.buffer<double>(length, 0);
+          auto* lineNearest = k ? workspace.buffer<Index>(length, 1) : nullptr;
+          auto* s = workspace.buffer<Index>(length, 2);
+          auto* t = workspace.buffer<Index>(length, 3);
+          auto* g = workspace.buffer<double>(length, 4);
+          auto* h = k ? workspace.buffer<Index>(length, 5) : nullptr;
+          for (const auto& p : grain) {
+            const auto first = out.index(p);
+            for (Index x = 0; x < length; ++x) {
+              line[x] = d[first + x * stride];
+            }
+            if (k) {
+              for (Index x = 0; x < length; ++x) {
+                lineNearest[x] = k[first + x * stride];
+              }
+            }
+            LineDistance<P>::apply(line, lineNearest, length, s, t, g, h);
+            for (Index x = 0; x < length; ++x) {
+              d[first + x * stride] = line[x];
+            }
+            if (k) {
+              for (Index x = 0; x < length; ++x) {
+                k[first + x * stride] = lineNearest[x];
+              }
+            }
+          }
+        },
+        std::max(defaultGrainSize / length, Index(1)),
+        pool);
+  }
+
+  for (Index i = 0; i < size; ++i) {
+    d[i] = LineDistance<P>::finalize(d[i]);
+  }
+  return out;
+}
+
+} // namespace Internal
+/// @endcond
+
+/**
+ * @ingroup filtering
+ * @brief Compute the distance of each pixel to the nearest feature pixel.
+ * @tparam P The norm: 1, 2 (Euclidean) or -1 (L∞)
+ * @param in The input raster
+ * @param predicate The feature predicate, which takes a pixel value as parameter
+ * @param pool The thread pool
+ * @details
+ * The transform is exact and computed in linear time, as one pass per axis,
+ * each of which is parallelized over the lines.
+ * The L2 and L∞ passes rely on a lower envelope (Felzenszwalb-Huttenlocher, Meijster et al.),
+ * while the L1 passes are forward and backward running minima.
+ * Feature pixels are at distance 0, and the distance is infinite if there is no feature pixel at all.
+ *
+ * Morphological operations with large balls are obtained in linear time by thresholding,
+ * e.g. the dilation of a mask by a ball of radius `r` is the set of pixels at distance at most `r`.
+ *
+ * \par_example
+ * \code
+ * const auto distances = distanceTransform(image, [](auto e) { return e > threshold; });
+ * const auto neighbors = std::count_if(distances.begin(), distances.end(), [=](auto d) {
+ *   return d > 0 && d <= radius; // Dilation by Ball<N, 2>(radius) minus the features
+ * });
+ * \endcode
+ */
+template <Index P = 2, typename TIn, typename TPredicate>
+Raster<double, TIn::Dimension>
+distanceTransform(const TIn& in, TPredicate&& predicate, ThreadPool& pool = ThreadPool::global()) {
+  return Internal::distanceTransformImpl<P>(in, std::forward<TPredicate>(predicate), nullptr, pool);
+}
+
+/**
+ * @ingroup filtering
+ * @brief Compute the distance of each pixel to the nearest feature pixel, and the index of this feature.
+ * @param in The input raster
+ * @param predicate The feature predicate, which takes a pixel value as parameter
+ * @param nearest The output raster of the raw indices of the nearest features, or -1 if there is no feature
+ * @param pool The thread pool
+ * @details
+ * In case of ties, the nearest feature is one of the equidistant features.
+ * @see distanceTransform(const TIn&, TPredicate&&, ThreadPool&)
+ */
+template <Index P = 2, typename TIn, typename TPredicate>
+Raster<double, TIn::Dimension> distanceTransform(
+    const TIn& in,
+    TPredicate&& predicate,
+    Raster<Index, TIn::Dimension>& nearest,
+    ThreadPool& pool = ThreadPool::global()) {
+  return Internal::distanceTransformImpl<P>(in, std::forward<TPredicate>(predicate), &nearest, pool);
+}
+
+/**
+ * @ingroup filtering
+ * @brief Compute the distance of each pixel to the nearest non-zero pixel.
+ * @see distanceTransform(const TIn&, TPredicate&&, ThreadPool&)
+ */
+template <Index P = 2, typename TIn>
+Raster<double, TIn::Dimension> distanceTransform(const TIn& in, ThreadPool& pool = ThreadPool::global()) {
+  return distanceTransform<P>(
+      in,
+      [](const auto& e) {
+        return e != 0;
+      },
+      pool);
+}
+
+} // namespace Litl
+
+#endif
@@ -0,0 +1,334 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLTRANSFORMS_INTEGRALIMAGE_H
+#define _LITLTRANSFORMS_INTEGRALIMAGE_H
+
+#include "LitlRaster/ParallelFor.h"
+#include "LitlRaster/Raster.h"
+
+#include <algorithm> // max, min
+
+namespace Litl {
+
+/**
+ * @brief Summed-area table, for constant-time box sums, means and variances.
+ * @tparam T The input value type
+ * @tparam N The dimension
+ * @details
+ * The integral image stores, at each position, the sum of the input values in the box
+ * which spans from the origin to this position.
+ * The sum of the values in any box is then obtained from the `2^N` corners of the box,
+ * independently of the box size.
+ * Optionally, the integral image of the squared values is computed, too,
+ * which enables local variance computations.
+ *
+ * Values are accumulated as `TypeTraits<T>::Accumulator`, e.g. 64-bit integers for integral inputs.
+ * Internally, the integral image is padded with zeros before the first index along each axis,
+ * such that no bound checking is required.
+ *
+ * Construction consists in a prefix scan along each axis, which is parallelized over the lines.
+ * Along axis 0, the scan is fused with the copy of the input values;
+ * along the other axes, it is performed as additions of whole rows, which the compiler vectorizes.
+ *
+ * \par_example
+ * \code
+ * const auto integral = integrate(image, true);
+ * const auto flux = integral.sum(aperture);
+ * const auto background = integral.mean(annulusBox);
+ * const auto noise = std::sqrt(integral.variance(annulusBox));
+ * const auto smoothed = integral.boxMean(Box<2>::fromCenter(10)); // Runtime independent of the radius
+ * \endcode
+ */
+template <typename T, Index N = 2>
+class IntegralImage {
+
+public:
+  /**
+   * @brief The accumulation type.
+   */
+  using Value = typename TypeTraits<T>::Accumulator;
+
+  /**
+   * @brief The floating point type of the means and variances.
+   */
+  using Floating = typename TypeTraits<Value>::Floating;
+
+  /**
+   * @brief The dimension.
+   */
+  static constexpr Index Dimension = N;
+
+  /// @{
+  /// @group_construction
+
+  /**
+   * @brief Constructor.
+   * @param in The input raster
+   * @param squares Compute the integral image of the squares, too
+   * @param pool The thread pool
+   */
+  template <typename TRaster>
+  explicit IntegralImage(const TRaster& in, bool squares = false, ThreadPool& pool = ThreadPool::global()) :
+      m_shape(in.shape()), m_sums(m_shape + 1), m_squares() {
+    build(
+        in,
+        m_sums,
+        [](const auto& e) {
+          return Value(e);
+        },
+        pool);
+    if (squares) {
+      m_squares = Raster<Value, N>(m_shape + 1);
+      build(
+          in,
+          m_squares,
+          [](const auto& e) {
+            const Value v(e);
+            return v * v;
+          },
+          pool);
+    }
+  }
+
+  /// @group_properties
+
+  /**
+   * @brief Get the shape of the input raster.
+   */
+  const Position<N>& shape() const {
+    return m_shape;
+  }
+
+  /**
+   * @brief Get the domain of the input raster.
+   */
+  Box<N> domain() const {
+    return Box<N>::fromShape(Position<N>::zero(), m_shape);
+  }
+
+  /**
+   * @brief Check whether the integral image of the squares was computed.
+   */
+  bool hasSquares() const {
+    return m_squares.size() > 0;
+  }
+
+  /// @group_operations
+
+  /**
+   * @brief Get the sum of the input values in a box.
+   * @details
+   * The box is cropped to the domain of the input raster.
+   */
+  Value sum(const Box<N>& box) const {
+    return cornerSum(m_sums, box);
+  }
+
+  /**
+   * @brief Get the sum of the squared input values in a box.
+   * @details
+   * The box is cropped to the domain of the input raster.
+   * The integral image of the squares must have been computed.
+   */
+  Value sumOfSquares(const Box<N>& box) const {
+    if (not hasSquares()) {
+      throw Exception("Cannot compute sum of squares: integral image of squares was not computed.");
+    }
+    return cornerSum(m_squares, box);
+  }
+
+  /**
+   * @brief Get the mean of the input values in a box.
+   * @details
+   * The box is cropped to the domain of the input raster, and the mean is computed over the cropped box.
+   */
+  Floating mean(const Box<N>& box) const {
+    return Floating(sum(box)) / Floating(croppedSize(box));
+  }
+
+  /**
+   * @brief Get the (biased) variance of the input values in a box.
+   * @details
+   * The box is cropped to the domain of the input raster.
+   * The integral image of the squares must have been computed.
+   */
+  Floating variance(const Box<N>& box) const {
+    const auto size = Floating(croppedSize(box));
+    const auto m = Floating(sum(box)) / size;
+    return Floating(sumOfSquares(box)) / size - m * m;
+  }
+
+  /**
+   * @brief Compute the mean of the input values in a window around each pixel.
+   * @param window The window, relative to each pixel, e.g. `Box<N>::fromCenter(radius)`
+   * @param pool The thread pool
+   * @details
+   * The window is cropped at the borders, which is equivalent to a normalized box filter.
+   */
+  Raster<Floating, N> boxMean(const Box<N>& window, ThreadPool& pool = ThreadPool::global()) const {
+    Raster<Floating, N> out(m_shape);
+    parallelForEachGrain(
+        out.domain(),
+        [&](const Box<N>& grain) {
+          for (const auto& e : out.enumerate(grain)) {
+            out[e.index] = mean(window + e.position);
+          }
+        },
+        defaultGrainSize,
+        pool);
+    return out;
+  }
+
+  /// @}
+
+private:
+  /**
+   * @brief Compute the prefix sums of some transform of the input values.
+   */
+  template <typename TRaster, typename TFunc>
+  static void build(const TRaster& in, Raster<Value, N>& out, TFunc&& transform, ThreadPool& pool) {
+
+    // Along axis 0, fused with the copy
+    parallelForEachRow(
+        in.domain(),
+        [&](const Position<N>& front, Index length) {
+          const auto* inIt = &in[front];
+          auto* outIt = &out[front + 1];
+          Value sum {};
+          for (Index i = 0; i < length; ++i) {
+            sum += transform(inIt[i]);
+            outIt[i] = sum;
+          }
+        },
+        defaultGrainSize,
+        pool);
+
+    // Along the other axes, as row additions
+    const auto dimension = out.dimension();
+    for (Index a = 1; a < dimension; ++a) {
+      const auto length = out.length(a);
+      if (length <= 2) {
+        continue;
+      }
+      const auto stride = out.stride(a);
+      auto front = Position<N>::one();
+      auto back = out.shape() - 1;
+      front[a] = 2; // Padding and first index are already valid
+      back[a] = 2;
+      parallelForEachRow(
+          Box<N>(front, back),
+          [&](const Position<N>& p, Index width) {
+            auto* current = &out[p];
+            for (Index k = 2; k < length; ++k, current += stride) {
+              const auto* previous = current - stride;
+              for (Index i = 0; i < width; ++i) {
+                current[i] += previous[i];
+              }
+            }
+          },
+          std::max(defaultGrainSize / length, Index(1)),
+          pool);
+    }
+  }
+
+  /**
+   * @brief Crop a box to the domain.
+   */
+  bool crop(const Box<N>& box, Position<N>& front, Position<N>& back) const {
+    front = box.front();
+    back = box.back();
+    for (std::size_t i = 0; i < front.size(); ++i) {
+      front[i] = std::max(front[i], Index(0));
+      back[i] = std::min(back[i], m_shape[i] - 1);
+      if (front[i] > back[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Get the number of pixels of a box cropped to the domain.
+   */
+  Index croppedSize(const Box<N>& box) const {
+    Position<N> front;
+    Position<N> back;
+    if (not crop(box, front, back)) {
+      return 0;
+    }
+    return shapeSize(back - front + 1);
+  }
+
+  /**
+   * @brief Sum the signed corners of a box in an integral image.
+   * @details
+   * In the padded integral image, the value at `p + 1` is the sum over the box from 0 to `p`.
+   * Positive and negative corners are accumulated separately, which is safe for unsigned accumulators.
+   */
+  Value cornerSum(const Raster<Value, N>& integral, const Box<N>& box) const {
+    Position<N> front;
+    Position<N> back;
+    if (not crop(box, front, back)) {
+      return Value {};
+    }
+    const auto dimension = integral.dimension();
+    const auto& strides = integral.strides();
+    auto jumps = back + 1 - front;
+    Index first = 0;
+    for (Index i = 0; i < dimension; ++i) {
+      first += front[i] * strides[i];
+      jumps[i] *= strides[i];
+    }
+    const auto* data = integral.data();
+    Value positive {};
+    Value negative {};
+    const Index count = Index(1) << dimension;
+    for (Index c = 0; c < count; ++c) {
+      auto index = first;
+      bool isNegative = false;
+      for (Index i = 0; i < dimension; ++i) {
+        if ((c >> i) & 1) {
+          index += jumps[i];
+        } else {
+          isNegative = not isNegative;
+        }
+      }
+      (isNegative ? negative : positive) += data[index];
+    }
+    return positive - negative;
+  }
+
+  /**
+   * @brief The input shape.
+   */
+  Position<N> m_shape;
+
+  /**
+   * @brief The padded integral image.
+   */
+  Raster<Value, N> m_sums;
+
+  /**
+   * @brief The padded integral image of the squares, or an empty raster.
+   */
+  Raster<Value, N> m_squares;
+};
+
+/**
+ * @relates IntegralImage
+ * @brief Make an integral image from a raster.
+ * @param in The input raster
+ * @param squares Compute the integral image of the squares, too
+ * @param pool The thread pool
+ */
+template <typename TRaster>
+IntegralImage<std::remove_const_t<typename TRaster::Value>, TRaster::Dimension>
+integrate(const TRaster& in, bool squares = false, ThreadPool& pool = ThreadPool::global()) {
+  return IntegralImage<std::remove_const_t<typename TRaster::Value>, TRaster::Dimension>(in, squares, pool);
+}
+
+} // namespace Litl
+
+#endif
@@ -5,13 +5,40 @@
 #ifndef _LITLTRANSFORMS_KERNEL_H
 #define _LITLTRANSFORMS_KERNEL_H
 
+#include "LitlContainer/Arena.h"
+#include "LitlContainer/Workspace.h"
 #include "LitlRaster/Raster.h"
+#include "LitlRaster/ThreadPool.h"
+#include "LitlTransforms/BlockCorrelation.h"
+#include "LitlTransforms/DftCorrelator.h"
 #include "LitlTransforms/Interpolation.h"
+#include "LitlTransforms/KernelBackend.h"
+#include "LitlTransforms/LineKernel.h"
+#include "LitlTransforms/Padding.h"
+
+#include <algorithm> // equal, reverse
+#include <cmath> // ceil
+#include <memory> // shared_ptr
+#include <mutex> // lock_guard, mutex
+#include <type_traits> // integral_constant, is_arithmetic
+#include <utility> // pair
+#include <vector>
 
 namespace Litl {
 
 /**
  * @brief A kernel which can be used for convolution or cross-correlation.
+ * @details
+ * Correlation of an extrapolator is performed by one of the backends of `KernelBackend`,
+ * which is selected automatically from the input shape, kernel window and value type, unless explicitly specified.
+ * Selections can be logged with `logKernelBackends()`.
+ *
+ * \par_example
+ * \code
+ * const auto psf = kernelize(psfValues); // 63x63
+ * const auto blurred = psf * extrapolate(image, 0.F); // Probably in the Fourier domain
+ * const auto exact = psf.correlate(extrapolate(image, 0.F), KernelBackend::Direct);
+ * \endcode
  */
 template <typename T, Index N = 2>
 class Kernel { // FIXME DataContainer
@@ -30,7 +57,9 @@ public:
   /**
    * @brief Constructor.
    */
-  Kernel(const T* values, Box<N> window) : m_values(values, values + window.size()), m_window(std::move(window)) {}
+  Kernel(const T* values, Box<N> window) :
+      m_values(values, values + window.size()), m_window(std::move(window)), m_tolerance(0), m_fractionBits(0),
+      m_terms(std::make_shared<SeparableCache>()), m_flipped(false) {}
 
   /**
    * @brief Get the window.
@@ -55,106 +84,680 @@ public:
 
   /**
    * @copybrief raster()
+   * @details
+   * The values can be modified through the returned view at any time:
+   * the cached separable decomposition is checked against the values each time it is used,
+   * and recomputed if they differ.
    */
   PtrRaster<Value, Dimension> raster() {
+    m_terms = std::make_shared<SeparableCache>();
+    m_flipped = false;
     return PtrRaster<Value, Dimension>(m_window.shape(), m_values.data());
   }
 
+  /**
+   * @brief Check whether the kernel is the outer product of 1D kernels, up to rounding errors.
+   * @details
+   * Only floating point kernels are decomposed.
+   */
+  bool isSeparable() const {
+    return not Internal::separableFactors(m_values.data(), shape()).empty();
+  }
+
+  /**
+   * @brief Get the relative tolerance of the separable decomposition used by the `Separable` backend.
+   */
+  double separationTolerance() const {
+    return m_tolerance;
+  }
+
+  /**
+   * @brief Set the relative tolerance of the separable decomposition used by the `Separable` backend.
+   * @details
+   * By default, the tolerance is 0, such that the decomposition is exact up to rounding errors.
+   * Increasing it allows nearly low-rank kernels, like most PSFs, to be correlated with a few separable terms.
+   *
+   * The decomposition is computed at the first correlation or backend selection which needs it,
+   * and is then cached until the tolerance or the values change.
+   * @see `separate()`
+   */
+  Kernel& setSeparationTolerance(double tolerance) {
+    if (tolerance != m_tolerance) {
+      m_tolerance = tolerance;
+      m_terms = std::make_shared<SeparableCache>();
+      m_flipped = false;
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Get the number of fractional bits of the kernel values.
+   */
+  Index fractionBits() const {
+    return m_fractionBits;
+  }
+
+  /**
+   * @brief Interpret integral kernel values as fixed-point numbers with a given number of fractional bits.
+   * @details
+   * Values are multiplied by `2^-bits`, such that the sums of the `Direct` backend are divided by `2^bits`,
+   * rounded to nearest, before they are written to the output.
+   * This allows integral inputs, e.g. raw frames, to be filtered with non-integral weights
+   * without converting them to floating point.
+   * Other backends are not supported for fixed-point kernels.
+   *
+   * \par_example
+   * \code
+   * const auto gaussian = kernelize(Raster<std::int16_t>({3, 3}, {1, 2, 1, 2, 4, 2, 1, 2, 1})).setFractionBits(4);
+   * Raster<std::uint8_t> smoothed(frame.shape());
+   * gaussian.correlateTo(extrapolate<NearestNeighbor>(frame), smoothed); // Sums / 16, accumulated in 16 bits
+   * \endcode
+   */
+  Kernel& setFractionBits(Index bits) {
+    if (not std::is_integral<T>::value && bits != 0) {
+      throw Exception("Only integral kernels can be fixed-point.");
+    }
+    if (bits < 0 || bits >= Index(8 * sizeof(typename Internal::BlockCorrelation<T>::Accumulator)) - 1) {
+      throw Exception("Invalid number of fractional bits.");
+    }
+    m_fractionBits = bits;
+    return *this;
+  }
+
+  /**
+   * @brief Decompose the kernel as a sum of separable kernels.
+   * @param tolerance The tolerance on the Frobenius norm of the residual, relative to that of the kernel
+   * @return The line kernels along each axis of each term, or an empty vector if the kernel is not decomposed
+   * @details
+   * 2D kernels are decomposed with a truncated singular value decomposition,
+   * which keeps the smallest number of terms such that the residual is within tolerance, or within rounding errors.
+   * Kernels of other dimensions are decomposed only if they are separable, in a single term.
+   * Only floating point kernels are decomposed.
+   *
+   * The `Separable` backend correlates with this decomposition, with `separationTolerance()`,
+   * if the number of terms times the sum of the window lengths is smaller than the window size.
+   *
+   * \par_example
+   * \code
+   * const auto terms = psf.separate(1.e-3);
+   * Raster<float> approx(psf.shape());
+   * for (const auto& p : approx.domain()) {
+   *   for (const auto& term : terms) {
+   *     approx[p] += term[0][p[0]] * term[1][p[1]];
+   *   }
+   * }
+   * \endcode
+   */
+  std::vector<std::vector<LineKernel<T>>> separate(double tolerance = 0) const {
+    const auto terms =
+        tolerance == m_tolerance ? *separableTerms() : Internal::separableTerms(m_values.data(), shape(), tolerance);
+    std::vector<std::vector<LineKernel<T>>> out(terms.size());
+    for (std::size_t k = 0; k < terms.size(); ++k) {
+      for (std::size_t i = 0; i < terms[k].size(); ++i) {
+        out[k].emplace_back(terms[k][i], -m_window.front()[i]);
+      }
+    }
+    return out;
+  }
+
+  /**
+   * @brief Select the cheapest backend to correlate an input of given shape.
+   * @param shape The input shape
+   * @param threads The number of threads of the parallel backends, which defaults to that of the global pool
+   * @return `Direct`, `Separable`, `Dft` or `TiledDft`
+   * @details
+   * `Separable` and `Dft` are only considered for floating point kernels.
+   */
+  KernelBackend
+  selectBackend(const Position<N>& shape, std::size_t threads = ThreadPool::global().threadCount()) const {
+    return Internal::KernelCosts::estimate(
+               shape,
+               m_window,
+               separableTerms()->size(),
+               std::is_floating_point<T>::value,
+               threads)
+        .best();
+  }
+
+  /**
+   * @brief Get the kernel which correlates like this kernel convolves.
+   */
+  Kernel flip() const {
+    const std::vector<T> values(m_values.rbegin(), m_values.rend());
+    Kernel out(values.data(), Box<N>(-m_window.back(), -m_window.front()));
+    out.m_tolerance = m_tolerance;
+    out.m_fractionBits = m_fractionBits;
+    out.m_terms = m_terms; // The terms of the flipped kernel are the flipped terms
+    out.m_flipped = not m_flipped;
+    return out;
+  }
+
   /**
    * @brief Cross-correlate a raster with the kernel.
    * @note
    * Correlation is like convolution with the reversed kernel.
    */
   template <typename TRaster, typename TMethod>
-  Raster<Value, Dimension> operator*(const Extrapolator<TRaster, TMethod>& in) {
+  Raster<Value, Dimension> operator*(const Extrapolator<TRaster, TMethod>& in) const {
+    return correlate(in);
+  }
+
+  /**
+   * @copybrief operator*()
+   * @param in The input extrapolator
+   * @param backend The backend
+   */
+  template <typename TRaster, typename TMethod>
+  Raster<Value, Dimension>
+  correlate(const Extrapolator<TRaster, TMethod>& in, KernelBackend backend = KernelBackend::Auto) const {
     Raster<Value, Dimension> out(in.shape());
-    correlateTo(in, out);
+    correlateTo(in, out, backend);
     return out;
   }
 
   /**
    * @copybrief operator*()
+   * @param in The input extrapolator
+   * @param out The output raster
+   * @param backend The backend
+   * @details
+   * With the other backends than `Direct`, the input is padded with the extrapolated values,
+   * and values are accumulated in floating point.
+   * With the `Direct` backend, integral kernels and inputs are accumulated in integers,
+   * which are only 16- or 32-bit wide if this cannot overflow, e.g. for 8- and 16-bit inputs.
+   * With all the backends, integral outputs are rounded to nearest and saturated to the range of their type.
+   *
+   * The `Direct` backend is run sequentially in the calling thread, with its scratch buffer in the current `Arena`
+   * if any, unless the input is large and no arena is in scope, in which case it is run on `ThreadPool::global()`.
+   * If the global pool is already running a batch, e.g. for another thread, the correlation falls back
+   * to sequential instead of waiting.
+   * An exception is thrown if the kernel is not decomposed in few enough separable terms for `Separable`
+   * (see `separate()`), or if it is not real for `Dft` and `TiledDft`.
+   */
+  template <typename TRaster, typename TMethod, typename TOut>
+  void correlateTo(
+      const Extrapolator<TRaster, TMethod>& in,
+      TOut& out,
+      KernelBackend backend = KernelBackend::Auto) const {
+    using TIn = std::remove_const_t<typename TRaster::Value>;
+    using IsReal = std::integral_constant<bool, std::is_arithmetic<T>::value && std::is_arithmetic<TIn>::value>;
+    static const auto noTerms = std::make_shared<const SeparableTerms>();
+    const auto cached = IsReal::value ? separableTerms() : noTerms; // Kept alive even if recomputed concurrently
+    const auto& terms = *cached;
+    const auto costs = Internal::KernelCosts::estimate(
+        in.shape(),
+        m_window,
+        terms.size(),
+        IsReal::value && std::is_floating_point<T>::value,
+        directThreadCount(in.domain()));
+    const bool forced = backend != KernelBackend::Auto;
+    if (not forced) {
+      backend = costs.best();
+    }
+    Internal::logKernelBackend(in.shape(), m_window, costs, backend, forced);
+    if (m_fractionBits != 0 && backend != KernelBackend::Direct) {
+      throw Exception("Fixed-point kernels only support the Direct backend.");
+    }
+    switch (backend) {
+      case KernelBackend::Separable:
+        if (not Internal::isSeparableWorthy(m_window, terms.size())) {
+          throw Exception("Kernel is not separable.");
+        }
+        correlateSpectral(in, out, backend, terms, IsReal());
+        return;
+      case KernelBackend::Dft:
+      case KernelBackend::TiledDft:
+        correlateSpectral(in, out, backend, terms, IsReal());
+        return;
+      default:
+        correlateDirect(in, out);
+    }
+  }
+
+  /**
+   * @brief Cross-correlate a raster with the kernel, with the `TiledDft` backend and a given tile shape.
+   * @param in The input extrapolator
+   * @param out The output raster
+   * @param tileShape The DFT shape, which must be larger than the window extended to the origin
+   * @param pool The thread pool
+   * @details
+   * Each thread holds a DFT plan of shape `tileShape`, and correlates output blocks which are shorter than the tiles
+   * by the extent of the window extended to the origin, minus one,
+   * such that large tiles waste less computation in the overlaps, while small tiles use less memory.
+   * FFTW is most efficient when the lengths have only small prime factors.
+   */
+  template <typename TRaster, typename TMethod, typename TOut>
+  void correlateTiledTo(
+      const Extrapolator<TRaster, TMethod>& in,
+      TOut& out,
+      const Position<N>& tileShape,
+      ThreadPool& pool = ThreadPool::global()) const {
+    static_assert(std::is_arithmetic<T>::value, "Tiled DFT correlation requires real kernels.");
+    Internal::tiledDftCorrelate(m_values.data(), m_window, in, out, tileShape, pool);
+  }
+
+  /**
+   * @brief Convolve a raster with the kernel.
+   * @param in The input extrapolator
+   * @param backend The backend
+   */
+  template <typename TRaster, typename TMethod>
+  Raster<Value, Dimension>
+  convolve(const Extrapolator<TRaster, TMethod>& in, KernelBackend backend = KernelBackend::Auto) const {
+    return flip().correlate(in, backend);
+  }
+
+  /**
+   * @copybrief convolve()
+   * @param in The input extrapolator
+   * @param out The output raster
+   * @param backend The backend
+   */
+  template <typename TRaster, typename TMethod, typename TOut>
+  void convolveTo(
+      const Extrapolator<TRaster, TMethod>& in,
+      TOut& out,
+      KernelBackend backend = KernelBackend::Auto) const {
+    flip().correlateTo(in, out, backend);
+  }
+
+  /**
+   * @brief Cross-correlate a raster with the kernel, with the `Direct` backend.
+   * @param in The input extrapolator
+   * @param out The output raster
+   * @param workspace The workspace, which provides the extrapolation buffer
+   */
+  template <typename TRaster, typename TMethod, typename TOut>
+  void correlateTo(const Extrapolator<TRaster, TMethod>& in, TOut& out, Workspace& workspace) const {
+    auto* buffer = workspace.template buffer<Accumulator>(m_values.size());
+    for (const auto& r : directRegions(in.domain())) {
+      if (r.second) {
+        correlateWithExtrapolation(in, r.first, out, buffer);
+      } else {
+        correlateWithoutExtrapolation(Litl::rasterize(in), r.first, out);
+      }
+    }
+  }
+
+  /**
+   * @brief Cross-correlate a raster with the kernel, with the `Direct` backend, in parallel.
+   * @param in The input extrapolator
+   * @param out The output raster
+   * @param pool The thread pool
+   * @details
+   * The interior region, where no extrapolation is needed, and the border regions
+   * are split into slabs along their outermost axes, in numbers proportional to their costs,
+   * which are correlated concurrently, each with the workspace of its thread.
+   * The workspaces of the threads are not allocated in the `Arena` of the caller, if any.
+   * Each output value is computed by a single task, as in sequential correlation,
+   * such that the output does not depend on the number of threads.
    */
   template <typename TRaster, typename TMethod, typename TOut>
-  void correlateTo(const Extrapolator<TRaster, TMethod>& in, TOut& out) {
-    const auto inner = in.domain() - m_window;
-    const auto outers = inner.surround(m_window);
-    correlateWithoutExtrapolation(Litl::rasterize(in), std::move(inner), out);
-    for (const auto& o : outers) {
-      correlateWithExtrapolation(in, o, out);
+  void correlateTo(const Extrapolator<TRaster, TMethod>& in, TOut& out, ThreadPool& pool) const {
+    const auto tasks = directTasks(in.domain(), pool.threadCount());
+    pool.run(tasks.size(), [&](std::size_t t) {
+      correlateDirectTask(in, tasks[t], out);
+    });
+  }
+
+  /**
+   * @copybrief operator*()
+   * @details
+   * The margin of the padded raster must contain the kernel window.
+   * No extrapolation is performed, such that the whole domain is processed in a single loop.
+   */
+  template <typename TIn>
+  Raster<Value, Dimension> operator*(const PaddedRaster<TIn, N>& in) const {
+    Raster<Value, Dimension> out(in.shape());
+    correlateTo(in, out);
+    return out;
+  }
+
+  /**
+   * @copydoc operator*(const PaddedRaster<TIn, N>&) const
+   */
+  template <typename TIn, typename TOut>
+  void correlateTo(const PaddedRaster<TIn, N>& in, TOut& out) const {
+    const auto& margin = in.margin();
+    for (Index i = 0; i < m_window.dimension(); ++i) {
+      if (m_window.front()[i] < margin.front()[i] || m_window.back()[i] > margin.back()[i]) {
+        throw Exception("Kernel window exceeds padding margin.");
+      }
     }
+    if (in.domain().size() == 0) {
+      return;
+    }
+
+    // Compute the offsets of the kernel rows in the padded raster
+    const auto& padded = in.raster();
+    const auto rowOffsets = kernelRowOffsets(padded);
+
+    // Loop over the output rows
+    const auto width = in.domain().template length<0>();
+    const auto* inData = padded.data();
+    const auto windowFront = m_window.front();
+    Internal::withIntegerAccumulator<TIn>(m_values.data(), m_values.size(), m_fractionBits, [&](auto accumulator) {
+      for (const auto& p : project(in.domain())) {
+        Internal::BlockCorrelation<T, decltype(accumulator)>::apply(
+            m_values.data(),
+            m_window.template length<0>(),
+            rowOffsets.data(),
+            rowOffsets.size(),
+            inData + in.index(p + windowFront),
+            width,
+            &out[p],
+            m_fractionBits);
+      }
+    });
   }
 
 private:
+  /**
+   * @brief The number of multiply-adds above which the `Direct` backend is worth running on the global pool.
+   */
+  static constexpr double parallelDirectWork() {
+    return 1 << 22;
+  }
+
+  /**
+   * @brief Get the number of threads which would run the `Direct` backend for a given input domain.
+   */
+  std::size_t directThreadCount(const Box<N>& domain) const {
+    const auto work = double(domain.size()) * m_values.size();
+    if (work < parallelDirectWork() || Arena::current() || ThreadPool::isInTask()) {
+      return 1;
+    }
+    return ThreadPool::global().threadCount();
+  }
+
+  /**
+   * @brief Cross-correlate with the `Direct` backend, in parallel if worth it and possible, sequentially otherwise.
+   */
+  template <typename TRaster, typename TMethod, typename TOut>
+  void correlateDirect(const Extrapolator<TRaster, TMethod>& in, TOut& out) const {
+    const auto domain = in.domain();
+    if (directThreadCount(domain) > 1) {
+      auto& pool = ThreadPool::global();
+      const auto tasks = directTasks(domain, pool.threadCount());
+      const auto done = pool.tryRun(tasks.size(), [&](std::size_t t) {
+        correlateDirectTask(in, tasks[t], out);
+      });
+      if (done) {
+        return;
+      }
+    }
+    if (Arena::current()) {
+      Workspace workspace; // In the arena
+      correlateTo(in, out, workspace);
+    } else {
+      correlateTo(in, out, Workspace::local());
+    }
+  }
+
+  /**
+   * @brief Split the interior and border regions of a domain into slabs, in numbers proportional to their costs.
+   */
+  std::vector<std::pair<Box<N>, bool>> directTasks(const Box<N>& domain, std::size_t threads) const {
+    std::vector<std::pair<Box<N>, bool>> tasks;
+    if (domain.size() == 0) {
+      return tasks;
+    }
+    const auto regions = directRegions(domain);
+    const auto cost = [](const std::pair<Box<N>, bool>& region) {
+      return double(region.first.size()) * (region.second ? 8 : 1); // See KernelCosts
+    };
+    double total = 0;
+    for (const auto& r : regions) {
+      total += cost(r);
+    }
+    const auto grain = total / (4 * threads);
+    for (const auto& r : regions) {
+      const auto& box = r.first;
+      auto axis = box.dimension() - 1;
+      while (axis > 0 && box.length(axis) == 1) {
+        --axis;
+      }
+      const auto length = box.length(axis);
+      const auto count = std::min(length, std::max<Index>(Index(std::ceil(cost(r) / grain)), 1));
+      for (Index k = 0; k < count; ++k) {
+        auto front = box.front();
+        auto back = box.back();
+        front[axis] = box.front()[axis] + k * length / count;
+        back[axis] = box.front()[axis] + (k + 1) * length / count - 1;
+        tasks.emplace_back(Box<N>(front, back), r.second);
+      }
+    }
+    return tasks;
+  }
+
+  /**
+   * @brief Correlate a slab with the `Direct` backend, with the workspace of the current thread.
+   */
+  template <typename TRaster, typename TMethod, typename TOut>
+  void correlateDirectTask(
+      const Extrapolator<TRaster, TMethod>& in,
+      const std::pair<Box<N>, bool>& task,
+      TOut& out) const {
+    if (task.second) {
+      auto* buffer = Workspace::local().template buffer<Accumulator>(m_values.size());
+      correlateWithExtrapolation(in, task.first, out, buffer);
+    } else {
+      correlateWithoutExtrapolation(Litl::rasterize(in), task.first, out);
+    }
+  }
+
+  /**
+   * @brief The 1D kernels along each axis of each term of a separable decomposition.
+   */
+  using SeparableTerms = std::vector<std::vector<std::vector<T>>>;
+
+  /**
+   * @brief The lazily computed separable decomposition with the current tolerance.
+   * @details
+   * The decomposition is shared by a kernel and its flipped copies, which differ by the order of the 1D kernels.
+   * The values it was computed from are stored, such that modifications through `raster()` are detected.
+   */
+  struct SeparableCache {
+
+    /**
+     * @brief The mutex which protects the cache against concurrent correlations.
+     */
+    std::mutex mutex;
+
+    /**
+     * @brief The kernel values, in the orientation of the unflipped kernel.
+     */
+    std::vector<T> values;
+
+    /**
+     * @brief The terms, in the orientation of the unflipped kernel, or null if not computed.
+     */
+    std::shared_ptr<const SeparableTerms> terms;
+
+    /**
+     * @brief The terms of the flipped kernel, or null if not computed.
+     */
+    std::shared_ptr<const SeparableTerms> flippedTerms;
+  };
+
+  /**
+   * @brief Reverse the 1D kernels of a separable decomposition.
+   */
+  static SeparableTerms flipTerms(SeparableTerms terms) {
+    for (auto& term : terms) {
+      for (auto& factor : term) {
+        std::reverse(factor.begin(), factor.end());
+      }
+    }
+    return terms;
+  }
+
+  /**
+   * @brief Get the separable decomposition with the current tolerance, which is computed if the values changed.
+   */
+  std::shared_ptr<const SeparableTerms> separableTerms() const {
+    auto& cache = *m_terms;
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    const bool upToDate = cache.terms &&
+        (m_flipped ? std::equal(m_values.rbegin(), m_values.rend(), cache.values.begin(), cache.values.end()) :
+                     m_values == cache.values);
+    if (not upToDate) {
+      auto terms = Internal::separableTerms(m_values.data(), shape(), m_tolerance);
+      if (m_flipped) {
+        cache.values.assign(m_values.rbegin(), m_values.rend());
+        cache.terms = std::make_shared<const SeparableTerms>(flipTerms(std::move(terms)));
+      } else {
+        cache.values = m_values;
+        cache.terms = std::make_shared<const SeparableTerms>(std::move(terms));
+      }
+      cache.flippedTerms = nullptr;
+    }
+    if (not m_flipped) {
+      return cache.terms;
+    }
+    if (not cache.flippedTerms) {
+      cache.flippedTerms = std::make_shared<const SeparableTerms>(flipTerms(*cache.terms));
+    }
+    return cache.flippedTerms;
+  }
+
+  /**
+   * @brief The accumulator type of the extrapolated values.
+   */
+  using Accumulator = typename Internal::BlockCorrelation<T>::Accumulator;
+
+  /**
+   * @brief Partition a domain into the region where no extrapolation is needed, and the border regions.
+   * @return The regions, each with a flag which is true if extrapolation is needed
+   * @details
+   * The interior region is computed even if the window does not contain the origin.
+   * If the window is larger than the domain, the whole domain is a border region.
+   */
+  std::vector<std::pair<Box<N>, bool>> directRegions(const Box<N>& domain) const {
+    auto front = domain.front() - m_window.front();
+    auto back = domain.back() - m_window.back();
+    for (std::size_t i = 0; i < front.size(); ++i) {
+      front[i] = std::max(front[i], domain.front()[i]);
+      back[i] = std::min(back[i], domain.back()[i]);
+      if (front[i] > back[i]) { // Window larger than the domain
+        return {{domain, true}};
+      }
+    }
+    const Box<N> inner(front, back);
+    std::vector<std::pair<Box<N>, bool>> out {{inner, false}};
+    for (const auto& b : inner.surround(Box<N>(domain.front() - front, domain.back() - back))) {
+      out.emplace_back(b, true);
+    }
+    return out;
+  }
+
+  /**
+   * @brief Correlate an extrapolator with the `Separable`, `Dft` or `TiledDft` backend.
+   */
+  template <typename TRaster, typename TMethod, typename TOut>
+  void correlateSpectral(
+      const Extrapolator<TRaster, TMethod>& in,
+      TOut& out,
+      KernelBackend backend,
+      const std::vector<std::vector<std::vector<T>>>& terms,
+      std::true_type) const {
+    if (backend == KernelBackend::TiledDft) {
+      correlateTiledTo(in, out, Internal::dftTileShape(in.shape(), m_window));
+    } else if (backend == KernelBackend::Dft) {
+      DftCorrelator<T, N>(m_values.data(), m_window).correlateTo(in, out);
+    } else {
+      Internal::separableCorrelate(terms, m_window, pad(in, Internal::paddingMargin(m_window)), out);
+    }
+  }
+
+  /**
+   * @brief Throw as spectral backends require real values.
+   */
+  template <typename TRaster, typename TMethod, typename TOut>
+  void correlateSpectral(
+      const Extrapolator<TRaster, TMethod>&,
+      TOut&,
+      KernelBackend,
+      const std::vector<std::vector<std::vector<T>>>&,
+      std::false_type) const {
+    throw Exception("Spectral kernel backends require real values.");
+  }
+
   /**
    * @brief Correlate an input raster over a given region.
    */
   template <typename TRasterIn, typename TRasterOut>
-  void correlateWithoutExtrapolation(const TRasterIn& in, Box<N> box, TRasterOut& out) {
+  void correlateWithoutExtrapolation(const TRasterIn& in, Box<N> box, TRasterOut& out) const {
 
     if (box.size() == 0) {
       return;
     }
 
     // Compute constants
-    auto boxWidth = box.template length<0>();
+    const auto boxWidth = box.template length<0>();
     box.project(); // Keep front hyperplane only
-    const auto inWidth = in.template length<0>();
-    const auto kWidth = m_window.template length<0>();
-    const auto kRowCount = m_window.size() / kWidth;
-
-    // Prepare iterators
-    auto inIt = in.data();
-    auto outIt = &out[box.front()];
-    auto kIt = m_values.data();
-    const auto distance = outIt - inIt;
-
-    // Loop over the hyperplane
-    for (const auto& p : box) {
-
-      // Loop over the rows which begin in the hyperplane
-      outIt = &out[p];
-      for (Index i = boxWidth; i > 0; --i, ++outIt, inIt = outIt - distance, kIt = m_values.data()) {
-
-        // Compute the weighted sum row by row
-        T sum {};
-        for (Index j = kRowCount; j > 0; --j, inIt += inWidth, kIt += kWidth) {
-          sum = std::inner_product(kIt, kIt + kWidth, inIt, sum);
-        }
-        *outIt = sum;
+    const auto rowOffsets = kernelRowOffsets(in);
+    const auto windowFront = m_window.front();
+
+    // Loop over the rows which begin in the hyperplane
+    using TIn = std::remove_const_t<typename TRasterIn::Value>;
+    Internal::withIntegerAccumulator<TIn>(m_values.data(), m_values.size(), m_fractionBits, [&](auto accumulator) {
+      for (const auto& p : box) {
+        Internal::BlockCorrelation<T, decltype(accumulator)>::apply(
+            m_values.data(),
+            m_window.template length<0>(),
+            rowOffsets.data(),
+            rowOffsets.size(),
+            &in[p + windowFront],
+            boxWidth,
+            &out[p],
+            m_fractionBits);
       }
+    });
+  }
+
+  /**
+   * @brief Compute the offsets of the kernel rows relative to the window front in some raster.
+   */
+  template <typename TRaster>
+  ArenaVector<Index> kernelRowOffsets(const TRaster& in) const {
+    const auto windowFront = m_window.front();
+    ArenaVector<Index> out;
+    out.reserve(m_window.size() / m_window.template length<0>());
+    for (const auto& q : project(m_window)) {
+      out.push_back(in.index(q - windowFront));
     }
+    return out;
   }
 
   /**
    * @brief Correlate an input raster over a given region.
    */
   template <typename TExtrapolatorIn, typename TRasterOut>
-  void correlateWithExtrapolation(const TExtrapolatorIn& in, const Box<N>& box, TRasterOut& out) {
+  void
+  correlateWithExtrapolation(const TExtrapolatorIn& in, const Box<N>& box, TRasterOut& out, Accumulator* buffer) const {
 
     if (box.size() == 0) {
       return;
     }
 
-    // Allocate extrapolation buffer
-    std::vector<T> buffer(m_values.size());
-
-    // Prepare iterators
-    const auto bBegin = buffer.begin();
-    const auto kBegin = m_values.begin();
-    const auto kEnd = m_values.end();
+    const auto size = m_values.size();
 
     // Loop over the box
     for (const auto& p : box) {
 
       // Fill the buffer
       const auto w = m_window + p;
-      std::transform(begin(w), end(w), buffer.begin(), [&](const auto& q) {
+      std::transform(begin(w), end(w), buffer, [&](const auto& q) {
         return in[q];
       });
 
       // Compute the weighted sum
-      out[p] = std::inner_product(kBegin, kEnd, bBegin, T {});
+      Accumulator sum {};
+      for (std::size_t i = 0; i < size; ++i) {
+        sum += Accumulator(m_values[i]) * buffer[i];
+      }
+      Internal::BlockCorrelation<T>::store(sum, m_fractionBits, out[p]);
     }
   }
 
@@ -168,6 +771,26 @@ private:
    * @brief The correlation window.
    */
   Box<N> m_window;
+
+  /**
+   * @brief The relative tolerance of the separable decomposition.
+   */
+  double m_tolerance;
+
+  /**
+   * @brief The number of fractional bits of fixed-point kernels.
+   */
+  Index m_fractionBits;
+
+  /**
+   * @brief The separable decomposition, which is shared by the copies of the kernel until they are modified.
+   */
+  std::shared_ptr<SeparableCache> m_terms;
+
+  /**
+   * @brief Whether the kernel is flipped with respect to the orientation of `m_terms`.
+   */
+  bool m_flipped;
 };
 
 /**
@@ -0,0 +1,801 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLTRANSFORMS_KERNELBACKEND_H
+#define _LITLTRANSFORMS_KERNELBACKEND_H
+
+#include "LitlContainer/Workspace.h"
+#include "LitlRaster/Raster.h"
+#include "LitlRaster/RegionCopy.h"
+#include "LitlTransforms/BlockCorrelation.h"
+#include "LitlTransforms/Dft.h"
+#include "LitlTransforms/Padding.h"
+
+#include <algorithm> // copy, max, min, swap
+#include <atomic>
+#include <cmath> // abs, log2, pow
+#include <complex>
+#include <eigen3/Eigen/SVD>
+#include <iomanip> // setprecision
+#include <limits>
+#include <memory> // unique_ptr
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <type_traits> // is_arithmetic, is_floating_point, is_integral
+#include <vector>
+
+namespace Litl {
+
+/**
+ * @relates Kernel
+ * @brief The algorithms which implement kernel correlation.
+ * @details
+ * - `Direct` computes the weighted sums in the spatial domain, in a time proportional to the window size;
+ * - `Separable` correlates along each axis in turn with 1D factors of the kernel,
+ *   in a time proportional to the sum of the window lengths times the number of separable terms,
+ *   and is available for floating point kernels which are the sum of `k` separable terms
+ *   with `k` times the sum of the window lengths smaller than the window size (see `Kernel::separate()`);
+ * - `Dft` multiplies the spectra of the padded input and of the kernel in the Fourier domain,
+ *   in a time which is almost independent of the window size, and is available for real kernels and inputs
+ *   (see `DftCorrelator` to reuse the kernel spectrum);
+ * - `TiledDft` is the overlap-save variant of `Dft`, which transforms FFT-friendly tiles in parallel,
+ *   such that the memory footprint is bounded by the tile size times the number of threads, instead of the image size;
+ * - `Auto` selects the cheapest available backend according to a cost model.
+ *
+ * All the backends produce the same results up to floating point rounding errors,
+ * including at the borders, where the input is extrapolated.
+ * In particular, they convert floating point results to integral outputs in the same way,
+ * by rounding to nearest and saturating.
+ * Automatic selection never picks the spectral backends for integer kernels, which are correlated exactly.
+ */
+enum class KernelBackend {
+  Auto, ///< Automatic selection
+  Direct, ///< Spatial weighted sums
+  Separable, ///< Successive 1D correlations
+  Dft, ///< Product in the Fourier domain
+  TiledDft ///< Tiled product in the Fourier domain
+};
+
+/**
+ * @relates KernelBackend
+ * @brief Insert the name of a backend into a stream.
+ */
+inline std::ostream& operator<<(std::ostream& os, KernelBackend backend) {
+  switch (backend) {
+    case KernelBackend::Auto:
+      return os << "Auto";
+    case KernelBackend::Direct:
+      return os << "Direct";
+    case KernelBackend::Separable:
+      return os << "Separable";
+    case KernelBackend::Dft:
+      return os << "Dft";
+    case KernelBackend::TiledDft:
+      return os << "TiledDft";
+  }
+  return os;
+}
+
+/// @cond INTERNAL
+namespace Internal {
+
+/**
+ * @brief The stream where the backend selections are logged, or `nullptr`.
+ */
+inline std::atomic<std::ostream*>& kernelBackendStream() {
+  static std::atomic<std::ostream*> stream(nullptr);
+  return stream;
+}
+
+/**
+ * @brief The mutex which serializes the writes to the log stream.
+ */
+inline std::mutex& kernelLogMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+/**
+ * @brief The mutex which serializes the creation and destruction of DFT plans, as the FFTW planner is not thread-safe.
+ */
+inline std::mutex& dftPlannerMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+/**
+ * @brief Deleter of DFT plans, which locks the planner mutex, such that plans can be destroyed in any context,
+ * including stack unwinding.
+ * @details
+ * The mutex must not be held by the calling thread.
+ */
+struct LockedPlanDeleter {
+  /**
+   * @brief Destroy a plan.
+   */
+  template <typename TPlan>
+  void operator()(TPlan* plan) const {
+    std::lock_guard<std::mutex> lock(dftPlannerMutex());
+    delete plan;
+  }
+};
+
+/**
+ * @brief Unique pointer to a DFT plan, which is destroyed with the planner mutex locked.
+ * @details
+ * Plans should be created with the mutex locked, in a narrower scope than the pointer.
+ */
+template <typename TPlan>
+using LockedPlanPtr = std::unique_ptr<TPlan, LockedPlanDeleter>;
+
+} // namespace Internal
+/// @endcond
+
+/**
+ * @relates KernelBackend
+ * @brief Log the backend of each kernel correlation, together with the estimated costs.
+ * @param stream The output stream, or `nullptr` to disable logging, which is the default
+ * @details
+ * One line is written per correlation, e.g.:
+ * \code
+ * Kernel: shape 4096x4096, window 31x31 -> TiledDft (direct: 1.8e+10, separable: inf, dft: 4.8e+09, tiled: 4.2e+08)
+ * \endcode
+ * The stream must outlive the correlations.
+ */
+inline void logKernelBackends(std::ostream* stream) {
+  std::lock_guard<std::mutex> lock(Internal::kernelLogMutex()); // Wait for the pending writes to the previous stream
+  Internal::kernelBackendStream().store(stream, std::memory_order_release);
+}
+
+/// @cond INTERNAL
+namespace Internal {
+
+/**
+ * @brief Get the smallest length greater than or equal to a given length whose prime factors are 2, 3, 5 or 7,
+ * for which FFTW is the most efficient.
+ */
+inline Index fastDftLength(Index length) {
+  for (Index n = std::max<Index>(length, 1);; ++n) {
+    Index m = n;
+    for (Index f : {2, 3, 5, 7}) {
+      while (m % f == 0) {
+        m /= f;
+      }
+    }
+    if (m == 1) {
+      return n;
+    }
+  }
+}
+
+/**
+ * @brief Get the default tile shape of the `TiledDft` backend.
+ * @details
+ * Tiles contain about 64k values, and are at least four times as long as the margin along each axis,
+ * such that the overlap is small, but no longer than needed to cover the padded input.
+ */
+template <Index N>
+Position<N> dftTileShape(const Position<N>& shape, const Box<N>& window) {
+  const auto margin = paddingMargin(window);
+  const auto minLength = Index(std::pow(65536., 1. / shape.size()));
+  auto out = shape;
+  for (std::size_t i = 0; i < out.size(); ++i) {
+    const auto halo = margin.length(i) - 1;
+    out[i] = std::min(fastDftLength(std::max(4 * (halo + 1), minLength)), fastDftLength(shape[i] + halo));
+  }
+  return out;
+}
+
+/**
+ * @brief Check whether a decomposition into separable terms is cheaper than the kernel,
+ * i.e. whether the number of terms times the sum of the window lengths is smaller than the window size.
+ */
+template <Index N>
+bool isSeparableWorthy(const Box<N>& window, std::size_t rank) {
+  Index lengths = 0;
+  for (Index i = 0; i < window.dimension(); ++i) {
+    lengths += window.length(i);
+  }
+  return rank > 0 && Index(rank) * lengths < window.size();
+}
+
+/**
+ * @brief Estimated costs of the kernel backends, in arbitrary units, or infinity for unavailable backends.
+ * @details
+ * The unit is roughly the time of a multiply-add of the register-blocked direct correlation:
+ * - Direct costs one unit per window value and interior pixel, and more at the borders,
+ *   where values are extrapolated one by one, divided by the number of threads;
+ * - Separable costs 1.5 units per window length and pixel of each pass of each term, plus the padding,
+ *   which is dominated by memory traffic;
+ * - Dft costs about `10 S log2(S)` for the three real transforms of size `S`, plus the padding and products,
+ *   plus a constant setup cost, such that small inputs are correlated in the spatial domain;
+ * - TiledDft costs the same per tile, for two transforms only, divided by the number of threads or tiles,
+ *   plus the kernel transform.
+ *
+ * Both DFT backends also create their plans at each correlation, with `FFTW_MEASURE`,
+ * which times several algorithms and is serialized by the planner mutex:
+ * each plan is estimated to cost `dftPlanningTransforms()` transforms of its size,
+ * which is pessimistic once FFTW has accumulated wisdom for the size.
+ */
+struct KernelCosts {
+
+  /**
+   * @brief The estimated cost of measuring a DFT plan, in number of transforms.
+   */
+  static constexpr double dftPlanningTransforms() {
+    return 8;
+  }
+
+  /**
+   * @brief Estimate the costs.
+   * @param shape The input shape
+   * @param window The kernel window
+   * @param rank The number of separable terms of the kernel, or 0 if it is not decomposed
+   * @param dft Whether the DFT backends are available
+   * @param threads The number of threads of the direct and tiled DFT backends
+   */
+  template <Index N>
+  static KernelCosts
+  estimate(const Position<N>& shape, const Box<N>& window, std::size_t rank, bool dft, std::size_t threads = 1) {
+    const auto infinity = std::numeric_limits<double>::infinity();
+    const auto dimension = shape.size();
+    const auto kernelSize = double(window.size());
+    double size = 1;
+    double innerSize = 1;
+    double paddedSize = 1;
+    double dftSize = 1;
+    for (std::size_t i = 0; i < dimension; ++i) {
+      const auto length = window.length(i);
+      const auto padded = shape[i] + std::max<Index>(window.back()[i], 0) - std::min<Index>(window.front()[i], 0);
+      size *= shape[i];
+      innerSize *= std::max<Index>(shape[i] - length + 1, 0);
+      paddedSize *= padded;
+      dftSize *= fastDftLength(padded);
+    }
+    KernelCosts out {(innerSize + 8 * (size - innerSize)) * kernelSize / threads, infinity, infinity, infinity};
+    if (isSeparableWorthy(window, rank)) {
+      out.separable = paddedSize * 30;
+      for (std::size_t i = 0; i < dimension; ++i) {
+        double passSize = 1; // Unpadded along the previous axes and the current axis
+        for (std::size_t j = 0; j < dimension; ++j) {
+          passSize *= j <= i ? shape[j] : shape[j] + window.length(j) - 1;
+        }
+        out.separable += passSize * window.length(i) * 1.5 * rank;
+      }
+    }
+    if (dft) {
+      const auto dftTransform = 10. / 3 * dftSize * std::log2(dftSize);
+      const auto dftPlanning = 2 * dftPlanningTransforms() * dftTransform; // Forward and inverse
+      out.dft = 3 * dftTransform + 4 * dftSize + paddedSize * 30 + dftPlanning + 1.e6;
+      const auto tile = dftTileShape(shape, window);
+      const auto margin = paddingMargin(window);
+      double tileSize = 1;
+      double tileCount = 1;
+      for (std::size_t i = 0; i < dimension; ++i) {
+        tileSize *= tile[i];
+        tileCount *= (shape[i] + tile[i] - margin.length(i)) / (tile[i] - margin.length(i) + 1);
+      }
+      const auto transform = 10. / 3 * tileSize * std::log2(tileSize);
+      const auto parallelism = std::min<double>(threads, tileCount);
+      const auto planning = (1 + 2 * parallelism) * dftPlanningTransforms() * transform; // Kernel, then per thread
+      out.tiledDft = transform + tileCount * (2 * transform + 34 * tileSize) / parallelism + planning + 1.e6;
+    }
+    return out;
+  }
+
+  /**
+   * @brief Get the cheapest backend.
+   */
+  KernelBackend best() const {
+    auto out = KernelBackend::Direct;
+    auto min = direct;
+    if (separable < min) {
+      out = KernelBackend::Separable;
+      min = separable;
+    }
+    if (dft < min) {
+      out = KernelBackend::Dft;
+      min = dft;
+    }
+    if (tiledDft < min) {
+      out = KernelBackend::TiledDft;
+    }
+    return out;
+  }
+
+  /**
+   * @brief The direct cost.
+   */
+  double direct;
+
+  /**
+   * @brief The separable cost.
+   */
+  double separable;
+
+  /**
+   * @brief The DFT cost.
+   */
+  double dft;
+
+  /**
+   * @brief The tiled DFT cost.
+   */
+  double tiledDft;
+};
+
+/**
+ * @brief Log a backend selection if a stream was set with `logKernelBackends()`.
+ */
+template <Index N>
+void logKernelBackend(
+    const Position<N>& shape,
+    const Box<N>& window,
+    const KernelCosts& costs,
+    KernelBackend backend,
+    bool forced) {
+  if (not kernelBackendStream().load(std::memory_order_acquire)) { // Fast path, without locking
+    return;
+  }
+  const auto join = [](const Position<N>& position) {
+    std::ostringstream oss;
+    for (std::size_t i = 0; i < position.size(); ++i) {
+      oss << (i ? "x" : "") << position[i];
+    }
+    return oss.str();
+  };
+  std::ostringstream line;
+  line << std::setprecision(2) << "Kernel: shape " << join(shape) << ", window " << join(window.shape()) << " -> "
+       << backend << (forced ? " (forced)" : "") << " (direct: " << costs.direct << ", separable: " << costs.separable
+       << ", dft: " << costs.dft << ", tiled: " << costs.tiledDft << ")";
+  std::lock_guard<std::mutex> lock(kernelLogMutex());
+  auto* stream = kernelBackendStream().load(std::memory_order_acquire); // Possibly changed meanwhile
+  if (stream) {
+    *stream << line.str() << std::endl;
+  }
+}
+
+/**
+ * @brief Decompose a kernel as the outer product of 1D kernels.
+ * @param values The kernel values
+ * @param shape The kernel shape
+ * @return The 1D kernels along each axis, or an empty vector if the kernel is not separable
+ * @details
+ * The kernel is separable if it is equal, up to rounding errors, to the outer product of its lines
+ * which pass through its largest value, suitably normalized.
+ * Only floating point kernels are decomposed.
+ */
+template <typename T, Index N>
+std::vector<std::vector<T>> separableFactors(const T* values, const Position<N>& shape) {
+  if (not std::is_floating_point<T>::value) {
+    return {};
+  }
+  const PtrRaster<const T, N> kernel(shape, values);
+  const auto domain = kernel.domain();
+
+  // Find the pivot
+  auto pivot = domain.front();
+  double max = 0;
+  for (const auto& p : domain) {
+    const double value = std::abs(kernel[p]);
+    if (value > max) {
+      max = value;
+      pivot = p;
+    }
+  }
+  if (max == 0) {
+    return {};
+  }
+
+  // Extract the lines which pass through the pivot
+  const auto dimension = shape.size();
+  std::vector<std::vector<T>> factors(dimension);
+  for (std::size_t i = 0; i < dimension; ++i) {
+    auto q = pivot;
+    const T norm = i == 0 ? T(1) : kernel[pivot];
+    for (q[i] = 0; q[i] < shape[i]; ++q[i]) {
+      factors[i].push_back(kernel[q] / norm);
+    }
+  }
+
+  // Check the outer product
+  const double tolerance = 64 * std::numeric_limits<typename TypeTraits<T>::Scalar>::epsilon() * max * dimension;
+  for (const auto& p : domain) {
+    T product = 1;
+    for (std::size_t i = 0; i < dimension; ++i) {
+      product *= factors[i][p[i]];
+    }
+    if (std::abs(product - kernel[p]) > tolerance) {
+      return {};
+    }
+  }
+  return factors;
+}
+
+/**
+ * @brief Decompose a 2D floating point kernel as a sum of outer products of 1D kernels with a truncated SVD.
+ * @copydetails separableTerms()
+ */
+template <typename T, Index N>
+std::vector<std::vector<std::vector<T>>>
+svdSeparableTerms(const T* values, const Position<N>& shape, double tolerance, std::true_type) {
+  const auto width = shape[0];
+  const auto height = shape[1];
+  Eigen::MatrixXd matrix(width, height);
+  double max = 0;
+  for (Index y = 0; y < height; ++y) {
+    for (Index x = 0; x < width; ++x, ++values) {
+      matrix(x, y) = *values;
+      max = std::max(max, std::abs(matrix(x, y)));
+    }
+  }
+  if (max == 0) {
+    return {};
+  }
+  const Eigen::BDCSVD<Eigen::MatrixXd> svd(matrix, Eigen::ComputeThinU | Eigen::ComputeThinV);
+  const auto& singulars = svd.singularValues();
+
+  // Drop the smallest terms while the Frobenius norm of the residual is within tolerance
+  const double rounding = 64 * std::numeric_limits<T>::epsilon() * max * 2;
+  const auto bound = std::max(tolerance * singulars.norm(), rounding);
+  auto rank = singulars.size();
+  double residual = 0;
+  while (rank > 0 && residual + singulars[rank - 1] * singulars[rank - 1] <= bound * bound) {
+    residual += singulars[rank - 1] * singulars[rank - 1];
+    --rank;
+  }
+
+  std::vector<std::vector<std::vector<T>>> terms(rank, std::vector<std::vector<T>>(2));
+  for (Index k = 0; k < rank; ++k) {
+    for (Index x = 0; x < width; ++x) {
+      terms[k][0].push_back(T(svd.matrixU()(x, k) * singulars[k]));
+    }
+    for (Index y = 0; y < height; ++y) {
+      terms[k][1].push_back(T(svd.matrixV()(y, k)));
+    }
+  }
+  return terms;
+}
+
+/**
+ * @brief Do not decompose non-floating point kernels.
+ */
+template <typename T, Index N>
+std::vector<std::vector<std::vector<T>>> svdSeparableTerms(const T*, const Position<N>&, double, std::false_type) {
+  return {};
+}
+
+/**
+ * @brief Decompose a kernel as a sum of outer products of 1D kernels.
+ * @param values The kernel values
+ * @param shape The kernel shape
+ * @param tolerance The relative tolerance on the Frobenius norm of the residual
+ * @return The 1D kernels along each axis of each term, or an empty vector if the kernel is not decomposed
+ * @details
+ * 2D kernels are decomposed with a singular value decomposition,
+ * which is truncated to the smallest number of terms such that the residual is within tolerance,
+ * or within rounding errors if the tolerance is smaller.
+ * Kernels of other dimensions are decomposed only if they are separable, with `separableFactors()`.
+ * Only floating point kernels are decomposed.
+ */
+template <typename T, Index N>
+std::vector<std::vector<std::vector<T>>> separableTerms(const T* values, const Position<N>& shape, double tolerance) {
+  if (shape.size() == 2) {
+    return svdSeparableTerms(values, shape, tolerance, std::is_floating_point<T>());
+  }
+  auto factors = separableFactors(values, shape);
+  if (factors.empty()) {
+    return {};
+  }
+  return {std::move(factors)};
+}
+
+/**
+ * @brief Copy the values of an extrapolator over a region into a raster, whose front corresponds to the region front.
+ * @details
+ * The parts of the rows which lie in the raster domain are copied directly,
+ * and only the values outside of the domain are extrapolated.
+ */
+template <typename TRaster, typename TMethod, typename TOut>
+void extrapolateRegion(const Extrapolator<TRaster, TMethod>& in, const Box<TRaster::Dimension>& region, TOut& out) {
+  const auto& raster = in.raster();
+  const auto& shape = raster.shape();
+  const auto width = region.length(0);
+  for (const auto& p : project(region)) {
+    auto* o = &out[p - region.front()];
+    bool inside = true;
+    for (std::size_t i = 1; i < p.size(); ++i) {
+      inside &= p[i] >= 0 && p[i] < shape[i];
+    }
+    const auto begin = inside ? std::min(std::max(-p[0], Index(0)), width) : width;
+    const auto end = inside ? std::min(std::max(shape[0] - p[0], begin), width) : width;
+    auto q = p;
+    for (Index x = 0; x < begin; ++x) {
+      q[0] = p[0] + x;
+      o[x] = in[q];
+    }
+    if (begin < end) {
+      q[0] = p[0] + begin;
+      const auto* row = &raster[q];
+      std::copy(row, row + (end - begin), o + begin);
+    }
+    for (Index x = end; x < width; ++x) {
+      q[0] = p[0] + x;
+      o[x] = in[q];
+    }
+  }
+}
+
+/**
+ * @brief Copy the unpadded region of a padded buffer into the output raster.
+ */
+template <typename TBuffer, Index N, typename TOut>
+void copyKernelOutput(const TBuffer& buffer, const Box<N>& region, TOut& out) {
+  using Value = std::remove_cv_t<typename TOut::Value>;
+  forEachRegionRow(buffer, region, out, Position<N>::zero(), [](const auto* in, Index length, auto* o) {
+    for (Index i = 0; i < length; ++i) {
+      o[i] = castKernelOutput<Value>(in[i]);
+    }
+  });
+}
+
+/**
+ * @brief Get the unpadded domain of a padded raster, in the padded raster coordinates.
+ */
+template <typename TIn, Index N>
+Box<N> unpaddedRegion(const PaddedRaster<TIn, N>& in) {
+  const auto front = -in.margin().front();
+  return Box<N>(front, front + in.shape() - 1);
+}
+
+/**
+ * @brief Correlate a padded buffer with the outer product of 1D kernels.
+ * @param factors The 1D kernels
+ * @param window The kernel window, which is contained in the margin
+ * @param shape The unpadded shape
+ * @param region The unpadded region in the padded buffer
+ * @param input The padded buffer, which is left untouched
+ * @param buffers Two padded buffers
+ * @return The buffer which contains the result
+ * @details
+ * Each pass correlates the input along an axis into the other buffer,
+ * over the unpadded domain along the previous axes, and the padded domain along the next axes.
+ * Along the first axis, rows are correlated with register blocking;
+ * along the other axes, whole contiguous slices are multiplied-added with `BlockCorrelation::applyInterleaved()`,
+ * such that no strided access is performed.
+ */
+template <typename T, Index N>
+const T* separablePasses(
+    const std::vector<std::vector<T>>& factors,
+    const Box<N>& window,
+    const Position<N>& shape,
+    const Box<N>& region,
+    const PtrRaster<const T, N>& input,
+    T* const* buffers) {
+  const auto& paddedShape = input.shape();
+  const auto* src = input.data();
+  const Index zero = 0;
+  for (std::size_t i = 0; i < factors.size(); ++i) {
+    auto* dst = buffers[i % 2];
+    auto front = region.front();
+    auto back = region.back();
+    for (std::size_t j = i + 1; j < factors.size(); ++j) {
+      front[j] = 0;
+      back[j] = paddedShape[j] - 1;
+    }
+    const auto* f = factors[i].data();
+    const auto length = window.length(i);
+    const auto width = shape[i];
+    const auto offset = front[i] + window.front()[i];
+    if (i == 0) {
+      for (const auto& p : project(Box<N>(front, back))) {
+        const auto row = input.index(p) - front[0];
+        BlockCorrelation<T>::apply(f, length, &zero, 1, src + row + offset, width, dst + row + front[0]);
+      }
+    } else {
+      const auto stride = shapeStride(paddedShape, i);
+      for (std::size_t j = 0; j <= i; ++j) {
+        front[j] = 0;
+        back[j] = 0;
+      }
+      for (const auto& p : Box<N>(front, back)) {
+        const auto slice = input.index(p);
+        for (Index u = 0; u < width; ++u) {
+          auto* o = dst + slice + (region.front()[i] + u) * stride;
+          BlockCorrelation<T>::applyInterleaved(f, length, src + slice + (offset + u) * stride, stride, stride, o);
+        }
+      }
+    }
+    src = dst;
+  }
+  return src;
+}
+
+/**
+ * @brief Correlate a padded raster with a sum of outer products of 1D kernels.
+ * @param terms The 1D kernels of each term
+ * @param window The kernel window, which is contained in the margin
+ * @param in The padded input
+ * @param out The output raster
+ * @details
+ * The padded input is converted once, and the terms are correlated with `separablePasses()` in turn,
+ * and summed over the unpadded region.
+ * The buffers, which are as large as the padded input, are taken from a local workspace,
+ * such that they are released on return, or allocated in the current `Arena` if any,
+ * instead of being kept by the workspace of the calling thread.
+ */
+template <typename T, typename TIn, Index N, typename TOut>
+void separableCorrelate(
+    const std::vector<std::vector<std::vector<T>>>& terms,
+    const Box<N>& window,
+    const PaddedRaster<TIn, N>& in,
+    TOut& out) {
+  const auto& padded = in.raster();
+  const auto& paddedShape = padded.shape();
+  const auto size = padded.size();
+  Workspace workspace;
+  auto* data = workspace.template buffer<T>(size, 0);
+  std::copy(padded.begin(), padded.end(), data); // Converted once
+  const PtrRaster<const T, N> input(paddedShape, data);
+  T* const buffers[] = {workspace.template buffer<T>(size, 1), workspace.template buffer<T>(size, 2)};
+  const auto region = unpaddedRegion(in);
+  if (terms.size() == 1) {
+    const auto* result = separablePasses(terms[0], window, in.shape(), region, input, buffers);
+    copyKernelOutput(PtrRaster<const T, N>(paddedShape, result), region, out);
+    return;
+  }
+  auto* sum = workspace.template buffer<T>(size, 3);
+  const auto width = region.length(0);
+  for (std::size_t t = 0; t < terms.size(); ++t) {
+    const auto* result = separablePasses(terms[t], window, in.shape(), region, input, buffers);
+    for (const auto& p : project(region)) {
+      const auto row = input.index(p);
+      if (t == 0) {
+        std::copy(result + row, result + row + width, sum + row);
+      } else {
+        for (Index x = 0; x < width; ++x) {
+          sum[row + x] += result[row + x];
+        }
+      }
+    }
+  }
+  copyKernelOutput(PtrRaster<const T, N>(paddedShape, sum), region, out);
+}
+
+/**
+ * @brief Compute the spectrum of a kernel wrapped around the origin of a DFT plan input.
+ */
+template <typename T, Index N>
+std::vector<std::complex<double>> dftKernelSpectrum(const T* values, const Box<N>& window, RealDft<N>& dft) {
+  const auto& shape = dft.logicalShape();
+  auto& signal = dft.in();
+  signal.fill(0);
+  const PtrRaster<const T, N> kernel(window.shape(), values);
+  for (const auto& q : window) {
+    auto r = q;
+    for (std::size_t i = 0; i < r.size(); ++i) {
+      r[i] = (r[i] + shape[i]) % shape[i];
+    }
+    signal[r] = kernel[q - window.front()];
+  }
+  dft.transform();
+  return std::vector<std::complex<double>>(dft.out().begin(), dft.out().end());
+}
+
+/**
+ * @brief Transform the input of a DFT plan, correlate it with a kernel spectrum, and transform it back.
+ */
+template <Index N>
+void dftCorrelateSpectrum(RealDft<N>& dft, typename RealDft<N>::Inverse& idft, const std::complex<double>* spectrum) {
+  dft.transform();
+  for (auto& c : dft.out()) {
+    c *= std::conj(*spectrum);
+    ++spectrum;
+  }
+  idft.transform().normalize();
+}
+
+/**
+ * @brief Correlate an extrapolator with a kernel in the Fourier domain, tile by tile (overlap-save method).
+ * @param values The kernel values
+ * @param window The kernel window
+ * @param in The input extrapolator
+ * @param out The output raster
+ * @param tileShape The DFT shape, which must be larger than the padding margin
+ * @param pool The thread pool
+ * @details
+ * The output is partitioned into blocks of shape `tileShape - margin.shape() + 1`,
+ * each of which is computed from a tile of shape `tileShape` of the extrapolated input,
+ * such that the circular correlation of the tile is the linear correlation over the block.
+ * The kernel spectrum is computed once, and each thread owns a pair of plans which it reuses for all of its tiles.
+ * Plans are created and destroyed with the planner mutex locked, also if a tile throws.
+ * Tiles are read with `extrapolateRegion()`.
+ */
+template <typename T, typename TRaster, typename TMethod, typename TOut>
+void tiledDftCorrelate(
+    const T* values,
+    const Box<TRaster::Dimension>& window,
+    const Extrapolator<TRaster, TMethod>& in,
+    TOut& out,
+    const Position<TRaster::Dimension>& tileShape,
+    ThreadPool& pool) {
+  static constexpr Index N = TRaster::Dimension;
+  using Value = std::remove_cv_t<typename TOut::Value>;
+  const auto margin = paddingMargin(window);
+  const auto& shape = in.shape();
+  auto block = tileShape;
+  auto counts = tileShape;
+  std::size_t tileCount = 1;
+  for (std::size_t i = 0; i < block.size(); ++i) {
+    block[i] = tileShape[i] - margin.length(i) + 1;
+    if (block[i] <= 0) {
+      throw Exception("DFT tile shape is smaller than the kernel window.");
+    }
+    counts[i] = (shape[i] + block[i] - 1) / block[i];
+    tileCount *= counts[i];
+  }
+  if (tileCount == 0) {
+    return;
+  }
+
+  // Transform the kernel once
+  LockedPlanPtr<RealDft<N>> dft;
+  {
+    std::lock_guard<std::mutex> lock(dftPlannerMutex());
+    dft.reset(new RealDft<N>(tileShape));
+  }
+  const auto spectrum = dftKernelSpectrum(values, window, *dft);
+  dft.reset();
+
+  // Process the tiles
+  std::atomic<std::size_t> next(0);
+  pool.run(std::min(pool.threadCount(), tileCount), [&](std::size_t) {
+    LockedPlanPtr<RealDft<N>> tileDft;
+    LockedPlanPtr<typename RealDft<N>::Inverse> tileIdft;
+    {
+      std::lock_guard<std::mutex> lock(dftPlannerMutex());
+      tileDft.reset(new RealDft<N>(tileShape));
+      tileIdft.reset(new typename RealDft<N>::Inverse(tileDft->inverse()));
+    }
+    auto& signal = tileDft->in();
+    const auto& result = tileIdft->out();
+    for (auto t = next++; t < tileCount; t = next++) {
+
+      // Locate the tile
+      auto front = block;
+      auto r = Index(t);
+      for (std::size_t i = 0; i < front.size(); ++i) {
+        front[i] = (r % counts[i]) * block[i];
+        r /= counts[i];
+      }
+      const auto inFront = front + margin.front();
+      const Box<N> inBox(inFront, inFront + tileShape - 1);
+      auto back = front + block - 1;
+      for (std::size_t i = 0; i < back.size(); ++i) {
+        back[i] = std::min(back[i], shape[i] - 1);
+      }
+
+      // Fill, correlate and crop
+      extrapolateRegion(in, inBox, signal);
+      dftCorrelateSpectrum(*tileDft, *tileIdft, spectrum.data());
+      const Box<N> outBox(front, back);
+      const auto width = outBox.length(0);
+      for (const auto& p : project(outBox)) {
+        const auto* row = &result[p - inFront];
+        auto* o = &out[p];
+        for (Index i = 0; i < width; ++i) {
+          o[i] = castKernelOutput<Value>(row[i]);
+        }
+      }
+    }
+  });
+}
+
+} // namespace Internal
+/// @endcond
+
+} // namespace Litl
+
+#endif
@@ -0,0 +1,352 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLTRANSFORMS_LABELING_H
+#define _LITLTRANSFORMS_LABELING_H
+
+#include "LitlRaster/ParallelFor.h"
+#include "LitlRaster/Raster.h"
+
+#include <algorithm> // max, min
+#include <vector>
+
+namespace Litl {
+
+/**
+ * @brief The connectivity of the pixels in connected-component labeling.
+ * @details
+ * Two pixels are neighbors if their positions differ by at most 1 along each axis,
+ * and along at most 1 (`Face`), 2 (`Edge`) or all (`Vertex`) axes.
+ * In 2D, `Face` is the 4-connectivity, while `Edge` and `Vertex` are the 8-connectivity.
+ * In 3D, they respectively are the 6-, 18- and 26-connectivities.
+ */
+enum class Connectivity {
+  Face, ///< Neighbors share a face
+  Edge, ///< Neighbors share at least an edge
+  Vertex ///< Neighbors share at least a vertex
+};
+
+/**
+ * @brief Statistics of a connected component.
+ */
+template <Index N = 2>
+struct Component {
+
+  /**
+   * @brief The label, from 1.
+   */
+  Index label;
+
+  /**
+   * @brief The number of pixels.
+   */
+  Index area;
+
+  /**
+   * @brief The bounding box.
+   */
+  Box<N> box;
+
+  /**
+   * @brief The sum of the input values.
+   */
+  double flux;
+
+  /**
+   * @brief The mean position.
+   */
+  Vector<double, N> center;
+
+  /**
+   * @brief The flux-weighted mean position, or the mean position if the flux is null.
+   */
+  Vector<double, N> centroid;
+};
+
+/**
+ * @brief The result of a connected-component labeling.
+ */
+template <Index N = 2>
+struct Labeling {
+
+  /**
+   * @brief The label map, where the background is 0 and the components are labeled from 1 in storage order.
+   */
+  Raster<Index, N> labels;
+
+  /**
+   * @brief The number of components.
+   */
+  Index count;
+
+  /**
+   * @brief The component statistics, ordered by label, if requested.
+   */
+  std::vector<Component<N>> components;
+};
+
+/// @cond INTERNAL
+namespace Internal {
+
+/**
+ * @brief Get the causal neighbor offsets of some connectivity, i.e. those which precede in storage order.
+ */
+template <Index N>
+std::vector<Position<N>> causalOffsets(Index dimension, Connectivity connectivity) {
+  const auto order = connectivity == Connectivity::Face ? 1 : connectivity == Connectivity::Edge ? 2 : dimension;
+  Position<N> front(dimension);
+  front.fill(-1);
+  std::vector<Position<N>> out;
+  for (const auto& o : Box<N>(front, -front)) {
+    Index nonzeros = 0;
+    Index last = 0;
+    for (Index i = 0; i < dimension; ++i) {
+      if (o[i] != 0) {
+        ++nonzeros;
+        last = o[i];
+      }
+    }
+    if (nonzeros > 0 && nonzeros <= order && last < 0) {
+      out.push_back(o);
+    }
+  }
+  return out;
+}
+
+/**
+ * @brief Check whether a position lies in a box.
+ */
+template <Index N>
+inline bool isInside(const Position<N>& position, const Box<N>& box) {
+  const auto& front = box.front();
+  const auto& back = box.back();
+  for (std::size_t i = 0; i < position.size(); ++i) {
+    if (position[i] < front[i] || position[i] > back[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Find the root of a tree, with path halving.
+ */
+inline Index findRoot(Index* parents, Index i) {
+  while (parents[i] != i) {
+    parents[i] = parents[parents[i]];
+    i = parents[i];
+  }
+  return i;
+}
+
+/**
+ * @brief Merge two trees, such that the root is the smallest index.
+ */
+inline void unite(Index* parents, Index i, Index j) {
+  i = findRoot(parents, i);
+  j = findRoot(parents, j);
+  if (i < j) {
+    parents[j] = i;
+  } else if (j < i) {
+    parents[i] = j;
+  }
+}
+
+/**
+ * @brief Accumulator of the component statistics.
+ */
+template <Index N>
+struct ComponentAccumulator {
+  Index area;
+  Position<N> front;
+  Position<N> back;
+  double flux;
+  Vector<double, N> positions;
+  Vector<double, N> weighted;
+};
+
+} // namespace Internal
+/// @endcond
+
+/**
+ * @relates Labeling
+ * @brief Label the connected components of the pixels which satisfy some predicate.
+ * @param in The input raster
+ * @param predicate The foreground predicate, which takes a pixel value as parameter
+ * @param connectivity The connectivity
+ * @param measure Compute the component statistics
+ * @param grainSize The number of pixels per block, or 0 for a few blocks per thread
+ * @param pool The thread pool
+ * @details
+ * The domain is partitioned into blocks of whole rows, which are labeled in parallel with a union-find structure.
+ * The components which cross the seams between blocks are then merged serially,
+ * and a final pass assigns the labels and accumulates the statistics, if requested.
+ * Large blocks minimize the amount of serial work at the seams.
+ *
+ * Labels are numbered from 1 in the storage order of the first pixel of each component,
+ * independently of the number of threads and blocks.
+ *
+ * \par_example
+ * \code
+ * const auto sources = label(image, [&](auto v) { return v > threshold; }, Connectivity::Vertex, true);
+ * for (const auto& c : sources.components) {
+ *   std::cout << c.label << ": " << c.flux << " @ " << c.centroid << std::endl;
+ * }
+ * \endcode
+ */
+template <typename TIn, typename TPredicate>
+Labeling<TIn::Dimension> label(
+    const TIn& in,
+    TPredicate&& predicate,
+    Connectivity connectivity = Connectivity::Face,
+    bool measure = false,
+    Index grainSize = 0,
+    ThreadPool& pool = ThreadPool::global()) {
+
+  static constexpr Index N = TIn::Dimension;
+  Labeling<N> out {Raster<Index, N>(in.shape()), 0, {}};
+  auto& labels = out.labels;
+  const auto size = Index(labels.size());
+  if (size == 0) {
+    return out;
+  }
+  const auto dimension = labels.dimension();
+  const auto domain = labels.domain();
+  if (grainSize <= 0) {
+    grainSize = std::max(size / Index(4 * pool.threadCount()), Index(1));
+  }
+  const auto blocks = partition(domain, grainSize, 1);
+  const auto offsets = Internal::causalOffsets<N>(dimension, connectivity);
+  std::vector<Index> indexOffsets;
+  for (const auto& o : offsets) {
+    indexOffsets.push_back(labels.index(o));
+  }
+  auto* parents = labels.data();
+
+  // Label the blocks independently
+  pool.run(blocks.size(), [&](std::size_t b) {
+    const auto& block = blocks[b];
+    for (const auto& e : labels.enumerate(block)) {
+      const auto i = e.index;
+      if (not predicate(in[i])) {
+        parents[i] = -1;
+        continue;
+      }
+      parents[i] = i;
+      for (std::size_t k = 0; k < offsets.size(); ++k) {
+        const auto j = i + indexOffsets[k];
+        if (Internal::isInside(e.position + offsets[k], block) && parents[j] >= 0) {
+          Internal::unite(parents, i, j);
+        }
+      }
+    }
+  });
+
+  // Merge at the seams
+  for (const auto& block : blocks) {
+    for (Index a = 1; a < dimension; ++a) {
+      for (const auto side : {block.front()[a], block.back()[a]}) {
+        auto front = block.front();
+        auto back = block.back();
+        front[a] = side;
+        back[a] = side;
+        for (const auto& e : labels.enumerate(Box<N>(front, back))) {
+          if (parents[e.index] < 0) {
+            continue;
+          }
+          for (std::size_t k = 0; k < offsets.size(); ++k) {
+            const auto q = e.position + offsets[k];
+            const auto j = e.index + indexOffsets[k];
+            if (Internal::isInside(q, domain) && not Internal::isInside(q, block) && parents[j] >= 0) {
+              Internal::unite(parents, e.index, j);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Relabel, knowing that parents precede children
+  if (not measure) {
+    for (Index i = 0; i < size; ++i) {
+      const auto p = parents[i];
+      parents[i] = p < 0 ? 0 : p == i ? ++out.count : parents[p];
+    }
+    return out;
+  }
+
+  // Relabel and accumulate the statistics in the same pass
+  using Accumulator = Internal::ComponentAccumulator<N>;
+  std::vector<Accumulator> totals;
+  Vector<double, N> zero(dimension);
+  zero.fill(0);
+  for (const auto& e : labels.enumerate()) {
+    const auto i = e.index;
+    const auto p = parents[i];
+    if (p < 0) {
+      parents[i] = 0;
+      continue;
+    }
+    if (p == i) {
+      parents[i] = ++out.count;
+      totals.push_back({0, e.position, e.position, 0, zero, zero});
+    } else {
+      parents[i] = parents[p];
+    }
+    auto& total = totals[parents[i] - 1];
+    const double value = in[i];
+    ++total.area;
+    total.flux += value;
+    for (Index a = 0; a < dimension; ++a) {
+      const auto x = e.position[a];
+      total.front[a] = std::min(total.front[a], x);
+      total.back[a] = std::max(total.back[a], x);
+      total.positions[a] += x;
+      total.weighted[a] += value * x;
+    }
+  }
+  out.components.reserve(out.count);
+  for (Index l = 0; l < out.count; ++l) {
+    const auto& total = totals[l];
+    auto center = total.positions;
+    center /= double(total.area);
+    auto centroid = center;
+    if (total.flux != 0) {
+      centroid = total.weighted;
+      centroid /= total.flux;
+    }
+    out.components.push_back({l + 1, total.area, Box<N>(total.front, total.back), total.flux, center, centroid});
+  }
+  return out;
+}
+
+/**
+ * @relates Labeling
+ * @brief Label the connected components of the non-zero pixels.
+ * @details
+ * This is the overload for binary masks, e.g. a `Raster<unsigned char>` of thresholding results.
+ * The pixel values are the fluxes of the component statistics, i.e. the fluxes of a mask are the areas.
+ * @see label(const TIn&, TPredicate&&, Connectivity, bool, Index, ThreadPool&)
+ */
+template <typename TIn>
+Labeling<TIn::Dimension> label(
+    const TIn& in,
+    Connectivity connectivity = Connectivity::Face,
+    bool measure = false,
+    Index grainSize = 0,
+    ThreadPool& pool = ThreadPool::global()) {
+  return label(
+      in,
+      [](const auto& e) {
+        return e != 0;
+      },
+      connectivity,
+      measure,
+      grainSize,
+      pool);
+}
+
+} // namespace Litl
+
+#endif
@@ -5,6 +5,7 @@
 #ifndef _LITLTRANSFORMS_MEDIANFILTER_H
 #define _LITLTRANSFORMS_MEDIANFILTER_H
 
+#include "LitlContainer/Workspace.h"
 #include "LitlRaster/Raster.h"
 #include "LitlTransforms/Interpolation.h"
 
@@ -61,14 +62,28 @@ public:
    */
   template <typename TIn, typename TOut>
   void applyTo(const TIn& in, TOut& out, const Box<N>& region = Box<N>::whole()) {
-    std::vector<typename TIn::Value> neighbors(m_window.size());
-    auto it = neighbors.begin();
+    Workspace workspace;
+    applyTo(in, out, region, workspace);
+  }
+
+  /**
+   * @brief Apply the filter into a given output raster, with a given workspace.
+   * @param in The input raster or an extrapolator
+   * @param out The output raster
+   * @param region The region to filter in the input raster
+   * @param workspace The workspace, which provides the neighbors buffer
+   */
+  template <typename TIn, typename TOut>
+  void applyTo(const TIn& in, TOut& out, const Box<N>& region, Workspace& workspace) {
+    using U = std::remove_const_t<typename TIn::Value>;
+    auto* neighbors = workspace.template buffer<U>(m_window.size());
+    auto* end = neighbors + m_window.size();
     for (const auto& p : region) {
+      auto it = neighbors;
       for (const auto& q : m_window + p) {
         *it++ = in[q];
       }
-      out[p] = median<typename TOut::Value>(neighbors);
-      it = neighbors.begin();
+      out[p] = median<typename TOut::Value>(neighbors, end);
     }
   }
 
@@ -79,8 +94,16 @@ public:
    */
   template <typename U, typename TIterable>
   static U median(TIterable& through) {
-    auto b = through.begin();
-    auto e = through.end();
+    return median<U>(through.begin(), through.end());
+  }
+
+  /**
+   * @brief Compute the median value of a range.
+   * @warning
+   * The range is modified (values are partially sorted).
+   */
+  template <typename U, typename TIt>
+  static U median(TIt b, TIt e) {
     const auto size = std::distance(b, e);
     auto n = b + size / 2;
     std::nth_element(b, n, e);
@@ -0,0 +1,194 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLTRANSFORMS_PADDING_H
+#define _LITLTRANSFORMS_PADDING_H
+
+#include "LitlRaster/Raster.h"
+#include "LitlRaster/RegionCopy.h"
+#include "LitlTransforms/Interpolation.h"
+
+#include <algorithm> // max, min
+
+namespace Litl {
+
+/// @cond INTERNAL
+namespace Internal {
+
+/**
+ * @brief Get the smallest padding margin which contains a kernel window, i.e. the window extended to the origin.
+ */
+template <Index N>
+Box<N> paddingMargin(const Box<N>& window) {
+  auto front = window.front();
+  auto back = window.back();
+  for (std::size_t i = 0; i < front.size(); ++i) {
+    front[i] = std::min<Index>(front[i], 0);
+    back[i] = std::max<Index>(back[i], 0);
+  }
+  return Box<N>(front, back);
+}
+
+} // namespace Internal
+/// @endcond
+
+/**
+ * @ingroup interpolation
+ * @brief Physically padded copy of a raster, as an alternative to an extrapolator.
+ * @tparam T The value type
+ * @tparam N The dimension
+ * @details
+ * The raster is copied into a larger buffer, whose margins are filled once by some extrapolator
+ * (e.g. `OutOfBoundsConstant`, `NearestNeighbor` or `Periodic`).
+ * The subscript operator accepts positions in the raster coordinates,
+ * which can lie anywhere in the padded domain, without bound checking nor extrapolation.
+ *
+ * This allows filters to run a single branch-free loop over the whole domain,
+ * instead of special-casing the borders,
+ * at the cost of the copy, which is generally negligible compared to the filtering itself.
+ * Padded rasters are accepted wherever extrapolators are (e.g. by `MedianFilter`),
+ * and `Kernel` processes them without any per-pixel indirection.
+ *
+ * \par_example
+ * \code
+ * const auto kernel = kernelize(values);
+ * const auto padded = pad(extrapolate<Periodic>(image), kernel.window());
+ * const auto filtered = kernel * padded;
+ * \endcode
+ */
+template <typename T, Index N = 2>
+class PaddedRaster {
+
+public:
+  /**
+   * @brief The value type.
+   */
+  using Value = T;
+
+  /**
+   * @brief The dimension parameter.
+   */
+  static constexpr Index Dimension = N;
+
+  /// @{
+  /// @group_construction
+
+  /**
+   * @brief Constructor.
+   * @param in The extrapolator which defines the margin values
+   * @param margin The margin, e.g. a kernel window
+   * @details
+   * The margin is extended to the origin with `Internal::paddingMargin()`,
+   * such that the indices of `margin().front()` are negative or null,
+   * and those of `margin().back()` are positive or null, i.e. the padded domain contains the unpadded domain.
+   */
+  template <typename TRaster, typename TMethod>
+  PaddedRaster(const Extrapolator<TRaster, TMethod>& in, const Box<N>& margin) :
+      m_shape(in.shape()), m_margin(Internal::paddingMargin(margin)), m_raster((in.domain() + m_margin).shape()),
+      m_offset(0) {
+    m_offset = -m_raster.index(m_margin.front());
+    const auto& raster = in.raster();
+    copyRegion(raster, raster.domain(), m_raster, -m_margin.front());
+    const auto front = m_margin.front();
+    for (const auto& outer : raster.domain().surround(m_margin)) {
+      for (const auto& e : m_raster.enumerate(outer - front)) {
+        m_raster[e.index] = in[e.position + front];
+      }
+    }
+  }
+
+  /// @group_properties
+
+  /**
+   * @brief Get the shape of the unpadded raster.
+   */
+  const Position<N>& shape() const {
+    return m_shape;
+  }
+
+  /**
+   * @brief Get the domain of the unpadded raster.
+   */
+  Box<N> domain() const {
+    return Box<N>::fromShape(Position<N>::zero(), m_shape);
+  }
+
+  /**
+   * @brief Get the margin.
+   */
+  const Box<N>& margin() const {
+    return m_margin;
+  }
+
+  /**
+   * @brief Get the padded domain, in the unpadded raster coordinates.
+   */
+  Box<N> paddedDomain() const {
+    return domain() + m_margin;
+  }
+
+  /**
+   * @brief Get the padded raster, whose front corresponds to `paddedDomain().front()`.
+   */
+  const Raster<T, N>& raster() const {
+    return m_raster;
+  }
+
+  /// @group_elements
+
+  /**
+   * @brief Get the raw index of a given position in the padded raster.
+   * @param position The position, in the unpadded raster coordinates
+   */
+  inline Index index(const Position<N>& position) const {
+    return m_offset + m_raster.index(position);
+  }
+
+  /**
+   * @brief Access the value at given position.
+   * @param position The position in the padded domain, in the unpadded raster coordinates
+   */
+  inline const T& operator[](const Position<N>& position) const {
+    return m_raster[index(position)];
+  }
+
+  /// @}
+
+private:
+  /**
+   * @brief The unpadded shape.
+   */
+  Position<N> m_shape;
+
+  /**
+   * @brief The margin.
+   */
+  Box<N> m_margin;
+
+  /**
+   * @brief The padded data.
+   */
+  Raster<T, N> m_raster;
+
+  /**
+   * @brief The raw index of the unpadded raster front.
+   */
+  Index m_offset;
+};
+
+/**
+ * @relates PaddedRaster
+ * @brief Pad a raster with the values of an extrapolator.
+ * @param in The extrapolator
+ * @param margin The margin, e.g. a kernel window
+ */
+template <typename TRaster, typename TMethod>
+PaddedRaster<std::remove_const_t<typename TRaster::Value>, TRaster::Dimension>
+pad(const Extrapolator<TRaster, TMethod>& in, const Box<TRaster::Dimension>& margin) {
+  return PaddedRaster<std::remove_const_t<typename TRaster::Value>, TRaster::Dimension>(in, margin);
+}
+
+} // namespace Litl
+
+#endif
@@ -0,0 +1,405 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef _LITLTRANSFORMS_RASTERPYRAMID_H
+#define _LITLTRANSFORMS_RASTERPYRAMID_H
+
+#include "LitlRaster/Raster.h"
+#include "LitlRaster/Sampling.h"
+#include "LitlTransforms/LineKernel.h"
+
+#include <algorithm> // max, min
+#include <type_traits> // conditional, remove_const
+#include <vector>
+
+namespace Litl {
+
+/**
+ * @brief Multiresolution pyramid of a raster, with lazily computed and cached levels.
+ * @tparam TRaster The base raster type, e.g. `Raster` or `PtrRaster`
+ * @details
+ * Level 0 is the base raster, and each subsequent level is downsampled by `factor()` along each axis
+ * (lengths are rounded up), until all the lengths equal 1.
+ * Downsampling is performed either by binning (averaging `factor()^N` pixels per bin)
+ * or by anti-aliased decimation, i.e. by correlating with a `LineKernel` along each axis
+ * at every `factor()`-th index only.
+ * Following `LineKernel` conventions, the kernel is cropped at the borders.
+ *
+ * Levels are computed when first accessed with `level()`, and are then cached.
+ * When the base raster is modified, the corresponding regions of the levels must be invalidated with `invalidate()`:
+ * only the affected regions are recomputed, at next access.
+ *
+ * \par_example
+ * \code
+ * RasterPyramid<Raster<float>> pyramid(std::move(image), LineKernel<float>({.25, .5, .25}));
+ * const auto& quicklook = pyramid.level(3); // Levels 1 to 3 are computed
+ * pyramid.base()[{10, 20}] = 0;
+ * pyramid.invalidate(Box<2>({10, 20}, {10, 20}));
+ * const auto& updated = pyramid.level(3); // Only a few pixels are recomputed
+ * \endcode
+ */
+template <typename TRaster>
+class RasterPyramid {
+
+public:
+  /**
+   * @brief The pixel value type.
+   */
+  using Value = std::remove_const_t<typename TRaster::Value>;
+
+  /**
+   * @brief The dimension.
+   */
+  static constexpr Index Dimension = TRaster::Dimension;
+
+  /**
+   * @brief The level raster type.
+   */
+  using Level = Raster<Value, Dimension>;
+
+  /// @{
+  /// @group_construction
+
+  /**
+   * @brief Constructor for downsampling by binning.
+   * @param base The base raster
+   * @param factor The downsampling factor, greater than 1
+   */
+  explicit RasterPyramid(TRaster base, Index factor = 2) :
+      RasterPyramid(std::move(base), LineKernel<Value>(std::vector<Value>()), factor) {}
+
+  /**
+   * @brief Constructor for downsampling by anti-aliased decimation.
+   * @param base The base raster
+   * @param filter The anti-aliasing filter, applied along each axis
+   * @param factor The downsampling factor, greater than 1
+   */
+  RasterPyramid(TRaster base, LineKernel<Value> filter, Index factor = 2) :
+      m_base(std::move(base)), m_filter(std::move(filter)), m_factor(factor), m_levels() {
+    OutOfBoundsError::mayThrow("factor", m_factor, {2, Limits<Index>::inf()});
+    auto shape = m_base.shape();
+    while (std::any_of(shape.begin(), shape.end(), [](auto s) {
+      return s > 1;
+    })) {
+      for (auto& s : shape) {
+        s = (s + m_factor - 1) / m_factor;
+      }
+      m_levels.push_back({Level(), shape, Box<Dimension>::fromShape(Position<Dimension>::zero(), shape), false});
+    }
+  }
+
+  /// @group_properties
+
+  /**
+   * @brief Get the base raster.
+   */
+  const TRaster& base() const {
+    return m_base;
+  }
+
+  /**
+   * @copybrief base()
+   * @details
+   * After modifying the base raster, the modified region must be invalidated.
+   * @see invalidate()
+   */
+  TRaster& base() {
+    return m_base;
+  }
+
+  /**
+   * @brief Get the downsampling factor.
+   */
+  Index factor() const {
+    return m_factor;
+  }
+
+  /**
+   * @brief Check whether the pyramid is built by binning (or by decimation).
+   */
+  bool isBinning() const {
+    return m_filter.size() == 0;
+  }
+
+  /**
+   * @brief Get the number of levels, including the base raster.
+   */
+  Index levelCount() const {
+    return m_levels.size() + 1;
+  }
+
+  /**
+   * @brief Get the shape of a given level, without computing it.
+   */
+  Position<Dimension> shape(Index index) const {
+    OutOfBoundsError::mayThrow("level", index, {0, levelCount() - 1});
+    if (index == 0) {
+      return m_base.shape();
+    }
+    return m_levels[index - 1].shape;
+  }
+
+  /**
+   * @brief Check whether a given level is up-to-date, i.e. accessing it is free.
+   */
+  bool isValid(Index index) const {
+    OutOfBoundsError::mayThrow("level", index, {0, levelCount() - 1});
+    return index == 0 || m_levels[index - 1].valid;
+  }
+
+  /// @group_elements
+
+  /**
+   * @brief Get a given level, computing it if needed.
+   * @param index The level index, from 1 to `levelCount() - 1`
+   * @details
+   * Finer levels are computed first if needed, and all of them are cached.
+   */
+  const Level& level(Index index) {
+    OutOfBoundsError::mayThrow("level", index, {1, levelCount() - 1});
+    auto& cache = m_levels[index - 1];
+    if (not cache.valid) {
+      if (index == 1) {
+        update(m_base, cache);
+      } else {
+        update(level(index - 1), cache);
+      }
+    }
+    return cache.raster;
+  }
+
+  /// @group_modifiers
+
+  /**
+   * @brief Invalidate the regions of the levels which depend on a given region of the base raster.
+   */
+  void invalidate(const Box<Dimension>& region) {
+    auto front = region.front();
+    auto back = region.back();
+    auto shape = m_base.shape();
+    const auto dimension = m_base.dimension();
+    const auto backward = m_filter.origin();
+    const auto forward = Index(m_filter.size()) - backward - 1;
+    for (auto& cache : m_levels) {
+      for (Index i = 0; i < dimension; ++i) {
+        front[i] = std::max(front[i], Index(0));
+        back[i] = std::min(back[i], shape[i] - 1);
+      }
+      shape = cache.shape;
+      for (Index i = 0; i < dimension; ++i) {
+        if (front[i] > back[i]) { // Empty region
+          return;
+        }
+        if (isBinning()) {
+          front[i] /= m_factor;
+          back[i] /= m_factor;
+        } else {
+          const auto f = front[i] - forward;
+          front[i] = f > 0 ? (f + m_factor - 1) / m_factor : 0;
+          back[i] = std::min((back[i] + backward) / m_factor, shape[i] - 1);
+        }
+      }
+      if (cache.valid) {
+        cache.region = Box<Dimension>(front, back);
+        cache.valid = false;
+      } else { // Merge with the already invalid region
+        auto f = cache.region.front();
+        auto b = cache.region.back();
+        for (Index i = 0; i < dimension; ++i) {
+          f[i] = std::min(f[i], front[i]);
+          b[i] = std::max(b[i], back[i]);
+        }
+        cache.region = Box<Dimension>(f, b);
+      }
+    }
+  }
+
+  /**
+   * @brief Invalidate all the levels.
+   */
+  void invalidate() {
+    invalidate(m_base.domain());
+  }
+
+  /// @}
+
+private:
+  /**
+   * @brief A cached level.
+   */
+  struct LevelCache {
+
+    /**
+     * @brief The level raster, empty until first computed.
+     */
+    Level raster;
+
+    /**
+     * @brief The level shape.
+     */
+    Position<Dimension> shape;
+
+    /**
+     * @brief The region to be computed, if invalid.
+     */
+    Box<Dimension> region;
+
+    /**
+     * @brief The validity flag.
+     */
+    bool valid;
+  };
+
+  /**
+   * @brief Compute the invalid region of a level from the previous level.
+   */
+  template <typename TParent>
+  void update(const TParent& parent, LevelCache& cache) {
+    if (cache.raster.size() == 0) { // Never computed
+      cache.raster = Level(cache.shape);
+      cache.region = cache.raster.domain();
+    }
+    if (isBinning()) {
+      bin(parent, cache.region, cache.raster);
+    } else {
+      decimate(parent, cache.region, cache.raster);
+    }
+    cache.valid = true;
+  }
+
+  /**
+   * @brief Average the bins of a parent raster over a given region.
+   */
+  template <typename TParent>
+  void bin(const TParent& parent, const Box<Dimension>& region, Level& out) const {
+    using Sum = std::conditional_t<std::is_integral<Value>::value, double, Value>;
+    const auto& shape = parent.shape();
+    for (const auto& e : out.enumerate(region)) {
+      auto front = e.position * m_factor;
+      auto back = front + (m_factor - 1);
+      for (std::size_t i = 0; i < back.size(); ++i) {
+        back[i] = std::min(back[i], shape[i] - 1);
+      }
+      const Box<Dimension> bin(front, back);
+      Sum sum {};
+      for (const auto& p : bin) {
+        sum += parent[p];
+      }
+      out[e.index] = static_cast<Value>(sum / Sum(bin.size()));
+    }
+  }
+
+  /**
+   * @brief Decimate a parent raster along each axis over a given region.
+   * @details
+   * The filter is applied along the successive axes.
+   * Before the pass along axis `i`, the intermediate raster covers the output region along the axes lower than `i`,
+   * and the input region which the output region depends on along the other axes.
+   */
+  template <typename TParent>
+  void decimate(const TParent& parent, const Box<Dimension>& region, Level& out) const {
+    const auto dimension = parent.dimension();
+    const auto backward = m_filter.origin();
+    const auto forward = Index(m_filter.size()) - backward - 1;
+    const auto& shape = parent.shape();
+    auto front = region.front();
+    auto back = region.back();
+    for (Index i = 0; i < dimension; ++i) {
+      front[i] = std::max(front[i] * m_factor - backward, Index(0));
+      back[i] = std::min(back[i] * m_factor + forward, shape[i] - 1);
+    }
+    const auto zero = Position<Dimension>::zero();
+    Box<Dimension> box(front, back);
+    Level in;
+    for (Index i = 0; i < dimension; ++i) {
+      front = box.front();
+      back = box.back();
+      front[i] = region.front()[i];
+      back[i] = region.back()[i];
+      const Box<Dimension> next(front, back);
+      const bool last = (i == dimension - 1);
+      Level tmp;
+      if (not last) {
+        tmp = Level(next.shape());
+      }
+      auto& dst = last ? out : tmp;
+      const auto& dstFront = last ? zero : next.front();
+      if (i == 0) {
+        decimateAlong(parent, zero, i, box, region, dst, dstFront);
+      } else {
+        decimateAlong(in, box.front(), i, box, region, dst, dstFront);
+      }
+      in = std::move(tmp);
+      box = next;
+    }
+  }
+
+  /**
+   * @brief Decimate the lines of a given box along a given axis.
+   * @param in The input raster
+   * @param inFront The position of the input raster in the box coordinates
+   * @param axis The decimation axis
+   * @param box The box to be processed
+   * @param region The output region
+   * @param out The output raster
+   * @param outFront The position of the output raster in the box coordinates
+   */
+  template <typename TIn>
+  void decimateAlong(
+      const TIn& in,
+      const Position<Dimension>& inFront,
+      Index axis,
+      const Box<Dimension>& box,
+      const Box<Dimension>& region,
+      Level& out,
+      const Position<Dimension>& outFront) const {
+    const auto from = region.front()[axis];
+    const auto to = region.back()[axis];
+    const IndexSampling inSampling {from * m_factor - inFront[axis], to * m_factor - inFront[axis], m_factor};
+    const IndexSampling outSampling {from - outFront[axis], to - outFront[axis], 1};
+    const auto inLength = std::size_t(in.shape()[axis]);
+    const auto outLength = std::size_t(out.shape()[axis]);
+    const auto inStride = in.stride(axis);
+    const auto outStride = out.stride(axis);
+    auto lines = project(box, axis);
+    Index count = 1;
+    if (axis > 0) { // Adjacent lines are contiguous and correlated at once
+      count = box.length(0);
+      lines.project(0);
+    }
+    for (const auto& p : lines) {
+      auto inPosition = p - inFront;
+      inPosition[axis] = 0;
+      auto outPosition = p - outFront;
+      outPosition[axis] = 0;
+      DataSamples<const typename TIn::Value> inSamples {&in[inPosition], inLength, inSampling, inStride};
+      DataSamples<Value> outSamples {&out[outPosition], outLength, outSampling, outStride};
+      m_filter.correlate(inSamples, outSamples, count);
+    }
+  }
+
+  /**
+   * @brief The base raster.
+   */
+  TRaster m_base;
+
+  /**
+   * @brief The anti-aliasing filter, or an empty kernel for binning.
+   */
+  LineKernel<Value> m_filter;
+
+  /**
+   * @brief The downsampling factor.
+   */
+  Index m_factor;
+
+  /**
+   * @brief The cached levels, from 1 to `levelCount() - 1`.
+   */
+  std::vector<LevelCache> m_levels;
+};
+
+} // namespace Litl
+
+#endif
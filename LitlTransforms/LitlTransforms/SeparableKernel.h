@@ -5,10 +5,15 @@
 #ifndef _LITLTRANSFORMS_SEPARABLEKERNEL_H
 #define _LITLTRANSFORMS_SEPARABLEKERNEL_H
 
+#include "LitlContainer/Workspace.h"
 #include "LitlRaster/Raster.h"
+#include "LitlRaster/ThreadPool.h"
+#include "LitlTransforms/BlockCorrelation.h"
 #include "LitlTransforms/Kernel.h"
 #include "LitlTransforms/LineKernel.h"
 
+#include <algorithm> // copy, fill, min, swap
+#include <atomic>
 #include <map>
 #include <vector>
 
@@ -16,6 +21,17 @@ namespace Litl {
 
 /**
  * @brief Separable correlation kernel as a sequence of oriented line kernels.
+ * @details
+ * Values outside of the input domain are considered null, i.e. the kernel is cropped at the bounds.
+ *
+ * Correlation is performed tile by tile, in parallel:
+ * each tile of the input, extended with the halo of the kernel, is loaded in a buffer which fits in the L2 cache,
+ * all the line kernels are applied in turn inside the buffers, and the output is written once.
+ * Along the first axis, rows are correlated with register blocking;
+ * along the other axes, contiguous slices of the buffer are multiplied-added
+ * with `BlockCorrelation::applyInterleaved()`, such that no strided access is performed.
+ * Along any axis, values are accumulated like with `Internal::BlockCorrelation`,
+ * i.e. as 64-bit integers for integral kernels, and the sums are saturated to the value type.
  */
 template <typename T, Index I0, Index... Is>
 class SeparableKernel {
@@ -101,54 +117,50 @@ public:
    * @brief The logical window of the kernel.
    */
   Box<Dimension> window() const {
-    Box<Dimension> box(Position<Dimension>::zero(), Position<Dimension>::zero());
+    auto front = Position<Dimension>::zero();
+    auto back = Position<Dimension>::zero();
     for (const auto& k : m_kernels) {
-      auto i = k.first;
-      const auto& w = k.second.window();
-      if (w.front() < box[i]) {
-        box[i] = w.front();
-      }
-      if (w.back() > box[i]) {
-        box[i] = w.back();
-      }
+      front[k.first] = -k.second.origin();
+      back[k.first] = k.second.size() - k.second.origin() - 1;
     }
-    return box;
+    return Box<Dimension>(front, back);
   }
 
   /**
    * @brief Get the `LineKernel` along given axis.
    */
-  const T& operator[](Index axis) const {
+  const LineKernel<T>& operator[](Index axis) const {
     return m_kernels.at(axis);
   }
 
   /**
    * @brief Beginning iterator over `{Index, LineKernel}` pairs.
    */
-  const decltype(auto) begin() const {
+  decltype(auto) begin() const {
     return m_kernels.begin();
   }
 
   /**
    * @brief End iterator over `{Index, LineKernel}` pairs.
    */
-  const decltype(auto) end() const {
+  decltype(auto) end() const {
     return m_kernels.end();
   }
 
   /**
-   * @brief Convolve the separable components as a single ND kernel.
+   * @brief Combine the separable components as a single ND kernel, i.e. compute their outer product.
    */
   Kernel<Value, Dimension> compose() const {
-    auto shape = Position<Dimension>::one();
-    auto origin = Position<Dimension>::zero();
-    for (const auto& k : m_kernels) {
-      shape[k.first] = k.second.size();
-      origin[k.first] = k.second.origin();
+    const auto box = window();
+    Raster<Value, Dimension> raster(box.shape());
+    for (const auto& p : box) {
+      T value = 1;
+      for (const auto& k : m_kernels) {
+        value *= k.second[p[k.first] + k.second.origin()];
+      }
+      raster[p - box.front()] = value;
     }
-    auto raster = Raster<Value, Dimension>(shape).fill(T(0));
-    raster[origin] = T(1);
-    return kernelize(*this * raster, origin);
+    return kernelize(raster.data(), box);
   }
 
   /**
@@ -172,20 +184,81 @@ public:
   }
 
   /**
-   * @copydoc correlate()
+   * @brief Apply the correlation kernels to an input raster.
+   * @param in The input raster
+   * @param out The output raster
+   * @param pool The thread pool
+   * @details
+   * Tiles are distributed to the threads of the pool, each of which holds its buffers in `Workspace::local()`.
    */
   template <typename TRasterIn, typename TRasterOut>
-  void correlateTo(const TRasterIn& in, TRasterOut& out) const {
-    correlateAlongSeqTo<TRasterIn, TRasterOut, I0, Is...>(in, out);
+  void correlateTo(const TRasterIn& in, TRasterOut& out, ThreadPool& pool = ThreadPool::global()) const {
+    static constexpr Index N = TRasterIn::Dimension;
+    const auto& shape = in.shape();
+
+    // Compute the halo and tiling
+    const auto extent = haloBox(shape);
+    const auto haloFront = extent.front();
+    const auto haloBack = extent.back();
+    const auto halo = haloBack - haloFront;
+    const auto tile = tileShape(shape, halo);
+    auto counts = tile;
+    std::size_t tileCount = 1;
+    std::size_t bufferSize = 1;
+    for (std::size_t i = 0; i < tile.size(); ++i) {
+      counts[i] = (shape[i] + tile[i] - 1) / std::max<Index>(tile[i], 1);
+      tileCount *= counts[i];
+      bufferSize *= tile[i] + halo[i];
+    }
+    if (tileCount == 0) {
+      return;
+    }
+
+    // Process the tiles
+    std::atomic<std::size_t> next(0);
+    pool.run(std::min(pool.threadCount(), tileCount), [&](std::size_t) {
+      auto& workspace = Workspace::local();
+      T* buffers[] = {workspace.template buffer<T>(bufferSize, 0), workspace.template buffer<T>(bufferSize, 1)};
+      for (auto t = next++; t < tileCount; t = next++) {
+
+        // Locate the tile
+        auto front = tile;
+        auto back = tile;
+        auto r = Index(t);
+        for (std::size_t i = 0; i < front.size(); ++i) {
+          front[i] = (r % counts[i]) * tile[i];
+          back[i] = std::min(front[i] + tile[i], shape[i]) - 1;
+          r /= counts[i];
+        }
+
+        // Load, correlate along each axis, and store
+        auto bufferShape = back - front + halo + 1;
+        loadTile(in, Box<N>(front + haloFront, back + haloBack), buffers[0]);
+        auto* src = buffers[0];
+        auto* dst = buffers[1];
+        for (const auto& k : m_kernels) {
+          correlateTileAlong(k.second, k.first, bufferShape, src, dst);
+          bufferShape[k.first] -= k.second.size() - 1;
+          std::swap(src, dst);
+        }
+        storeTile(PtrRaster<const T, N>(bufferShape, src), front, out);
+      }
+    });
   }
 
   /**
    * @brief Sparsely apply the correlation kernels to an input raster.
+   * @details
+   * The correlation is computed over the bounding box of the samples only, and then decimated.
+   * Like with `correlateTo()`, values outside of the input domain are considered null.
+   * The buffers, which can be as large as the input, are taken from a local workspace,
+   * such that they are released on return, or allocated in the current `Arena` if any.
    */
   template <Index N, typename TRasterIn>
   Raster<T, N> correlateSamples(const TRasterIn& in, const PositionSampling<N>& sampling) const {
     Raster<T, N> out(sampling.shape());
     correlateSamplesTo(in, sampling, out);
+    return out;
   }
 
   /**
@@ -193,60 +266,176 @@ public:
    */
   template <typename TRasterIn, Index N, typename TRasterOut>
   void correlateSamplesTo(const TRasterIn& in, const PositionSampling<N>& sampling, TRasterOut& out) const {
-    correlateSamplesAlongSeqTo<TRasterIn, N, TRasterOut, I0, Is...>(in, sampling, out);
-  }
+    using OutValue = std::remove_cv_t<typename TRasterOut::Value>;
+
+    // Compute the bounding box of the samples
+    const auto counts = sampling.shape();
+    auto front = counts;
+    auto back = counts;
+    auto step = counts;
+    std::size_t bufferSize = 1;
+    const auto extent = haloBox(in.shape());
+    const auto halo = extent.back() - extent.front();
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+      if (counts[i] <= 0) {
+        return;
+      }
+      const auto& s = sampling.along(i);
+      front[i] = s.front;
+      step[i] = s.step;
+      back[i] = s.front + s.step * (counts[i] - 1);
+      bufferSize *= back[i] - front[i] + 1 + halo[i];
+    }
 
-private:
-  template <typename TRasterIn, typename TRasterOut, Index J0, Index... Js>
-  void correlateAlongSeqTo(const TRasterIn& in, TRasterOut& out) const {
-    const auto tmp = correlateAlong<TRasterIn, TRasterOut, J0>(in);
-    correlateAlongSeqTo<TRasterOut, TRasterOut, Js...>(tmp, out);
-    printf("%li: %i -> %i\n", J0, tmp[0], out[0]);
-  }
+    // Correlate the bounding box
+    Workspace workspace;
+    T* buffers[] = {workspace.template buffer<T>(bufferSize, 0), workspace.template buffer<T>(bufferSize, 1)};
+    auto bufferShape = back - front + halo + 1;
+    loadTile(in, Box<N>(front + extent.front(), back + extent.back()), buffers[0]);
+    auto* src = buffers[0];
+    auto* dst = buffers[1];
+    for (const auto& k : m_kernels) {
+      correlateTileAlong(k.second, k.first, bufferShape, src, dst);
+      bufferShape[k.first] -= k.second.size() - 1;
+      std::swap(src, dst);
+    }
 
-  template <typename TRasterIn, typename TRasterOut>
-  void correlateAlongSeqTo(const TRasterIn& in, TRasterOut& out) const {
-    out = in; // FIXME swap? move?
+    // Decimate
+    const PtrRaster<const T, N> correlated(bufferShape, src);
+    for (const auto& q : out.domain()) {
+      auto p = q;
+      for (std::size_t i = 0; i < p.size(); ++i) {
+        p[i] *= step[i];
+      }
+      out[q] = Internal::castKernelOutput<OutValue>(correlated[p]);
+    }
   }
 
-  template <typename TRasterIn, typename TRasterOut, Index J>
-  TRasterOut correlateAlong(const TRasterIn& in) const {
-    const auto shape = in.shape();
-    const auto length = shape[J];
-    const auto stride = shapeStride<J>(shape);
-    const auto domain = in.domain().project(J);
-    TRasterOut out(shape);
-    for (const auto& p : domain) {
-      DataSamples<const typename TRasterIn::Value> inSamples {&in[p], length, {}, stride};
-      DataSamples<typename TRasterOut::Value> outSamples {&out[p], length, {}, stride};
-      m_kernels.at(J).correlate(inSamples, outSamples);
+private:
+  /**
+   * @brief Get the shape of the tiles, such that an extended tile fits in half of a typical L2 cache.
+   * @details
+   * Tiles are shrunk along the last axes first, in order to keep long rows.
+   */
+  template <Index N>
+  static Position<N> tileShape(const Position<N>& shape, const Position<N>& halo) {
+    const Index budget = (1 << 17) / sizeof(T);
+    auto out = shape;
+    const auto extendedSize = [&]() {
+      Index size = 1;
+      for (std::size_t i = 0; i < out.size(); ++i) {
+        size *= out[i] + halo[i];
+      }
+      return size;
+    };
+    for (auto i = Index(out.size()) - 1; i >= 0; --i) {
+      while (extendedSize() > budget && out[i] > std::max<Index>(halo[i], 1)) {
+        out[i] = (out[i] + 1) / 2;
+      }
     }
     return out;
   }
 
-  template <typename TRasterIn, Index N, typename TRasterOut, Index J0, Index... Js>
-  void correlateSamplesAlongSeqTo(const TRasterIn& in, const PositionSampling<N>& sampling, TRasterOut& out) const {
-    auto box = correlationBox(sampling, in.shape()); // FIXME make unit and dilate
-    correlateAlongSeqTo<TRasterIn, N, TRasterOut, Js...>(in, box, out);
-    // FIXME m_kernels[J0]->correlateSamplesAlongTo<J0>(in, sampling, out)
+  /**
+   * @brief Copy an input region into a buffer, with zeros outside of the input domain.
+   */
+  template <typename TRasterIn, Index N>
+  static void loadTile(const TRasterIn& in, const Box<N>& region, T* buffer) {
+    const auto& shape = in.shape();
+    PtrRaster<T, N> tile(region.shape(), buffer);
+    auto front = region.front();
+    auto back = region.back();
+    bool clipped = false;
+    for (std::size_t i = 0; i < front.size(); ++i) {
+      clipped |= front[i] < 0 || back[i] >= shape[i];
+      front[i] = std::max<Index>(front[i], 0);
+      back[i] = std::min(back[i], shape[i] - 1);
+      if (front[i] > back[i]) {
+        tile.fill(T());
+        return;
+      }
+    }
+    if (clipped) {
+      tile.fill(T());
+    }
+    const Box<N> box(front, back);
+    const auto width = box.length(0);
+    for (const auto& p : project(box)) {
+      const auto* i = &in[p];
+      std::copy(i, i + width, &tile[p - region.front()]);
+    }
   }
 
+  /**
+   * @brief Correlate a buffer with a line kernel along a given axis into a second buffer.
+   * @param kernel The line kernel
+   * @param axis The axis
+   * @param shape The shape of the input buffer, which is shrunk along the axis by the kernel size minus one
+   * @param in The input buffer
+   * @param out The output buffer
+   */
   template <Index N>
-  Box<N> correlationBox(const PositionSampling<N>& sampling, const Position<N>& shape) const {
-    auto box = sampling.region();
-    for (const auto& p : m_kernels) {
-      auto& front = box.front[p.first];
-      front -= p.second.origin();
-      if (front < 0) {
-        front = 0;
+  static void
+  correlateTileAlong(const LineKernel<T>& kernel, Index axis, const Position<N>& shape, const T* in, T* out) {
+    const auto* values = kernel.data();
+    const auto size = Index(kernel.size());
+    Index inner = 1;
+    Index outer = 1;
+    for (Index i = 0; i < Index(shape.size()); ++i) {
+      if (i < axis) {
+        inner *= shape[i];
+      } else if (i > axis) {
+        outer *= shape[i];
+      }
+    }
+    const auto inLength = shape[axis];
+    const auto outLength = inLength - size + 1;
+    if (inner == 1) {
+      const Index zero = 0;
+      for (Index o = 0; o < outer; ++o) {
+        Internal::BlockCorrelation<T>::apply(values, size, &zero, 1, in + o * inLength, outLength, out + o * outLength);
+      }
+      return;
+    }
+    for (Index o = 0; o < outer; ++o) {
+      for (Index u = 0; u < outLength; ++u) {
+        const auto* front = in + (o * inLength + u) * inner;
+        auto* slice = out + (o * outLength + u) * inner;
+        Internal::BlockCorrelation<T>::applyInterleaved(values, size, front, inner, inner, slice);
       }
-      auto& back = box.back[p.first];
-      back += p.second.size() - p.second.origin() - 1;
-      if (back >= shape[p.first]) {
-        back = shape[p.first] - 1;
+    }
+  }
+
+  /**
+   * @brief Copy a buffer into the output raster at a given position.
+   */
+  template <Index N, typename TRasterOut>
+  static void storeTile(const PtrRaster<const T, N>& tile, const Position<N>& front, TRasterOut& out) {
+    using Value = std::remove_cv_t<typename TRasterOut::Value>;
+    const auto width = tile.shape()[0];
+    for (const auto& p : project(tile.domain())) {
+      const auto* t = &tile[p];
+      auto* o = &out[p + front];
+      for (Index i = 0; i < width; ++i) {
+        o[i] = Internal::castKernelOutput<Value>(t[i]);
       }
     }
-    return box; //FIXME box.grow(amount).clamp(shape)
+  }
+
+  /**
+   * @brief Get the offsets of the front and back of the kernels along each axis of an input raster.
+   */
+  template <Index N>
+  Box<N> haloBox(const Position<N>& shape) const {
+    auto front = shape;
+    auto back = shape;
+    std::fill(front.begin(), front.end(), 0);
+    std::fill(back.begin(), back.end(), 0);
+    for (const auto& k : m_kernels) {
+      front[k.first] = -k.second.origin();
+      back[k.first] = k.second.size() - k.second.origin() - 1;
+    }
+    return Box<N>(front, back);
   }
 
 private:
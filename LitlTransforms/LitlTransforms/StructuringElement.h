@@ -78,8 +78,9 @@ public:
   }
 
 private:
+  template <typename TIn>
   void loadNeighbors(const TIn& in, const Position<N>& p) {
-    auto it = neighbors.begin();
+    auto it = m_neighbors.begin();
     for (const auto& q : m_window + p) {
       *it++ = in[q];
     }
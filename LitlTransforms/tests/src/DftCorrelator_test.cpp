@@ -0,0 +1,87 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlTransforms/DftCorrelator.h"
+#include "LitlTransforms/Kernel.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(DftCorrelator_test)
+
+//-----------------------------------------------------------------------------
+
+template <typename TRaster>
+void checkEqual(const TRaster& out, const TRaster& expected) {
+  for (const auto& p : expected.domain()) {
+    BOOST_TEST(out[p] == expected[p], boost::test_tools::tolerance(1.e-9));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(stream_test) {
+  Raster<double> values({5, 4});
+  values.range(-7);
+  const auto kernel = kernelize(values, {3, 0});
+  DftCorrelator<double> correlator(kernel);
+  BOOST_TEST(correlator.planCount() == 0);
+  Raster<double> frame({31, 17});
+  for (int i = 0; i < 3; ++i) {
+    frame.range(i * 10 - 100);
+    checkEqual(correlator * extrapolate(frame, 2.), kernel.correlate(extrapolate(frame, 2.), KernelBackend::Direct));
+    const auto extrapolator = extrapolate<Periodic>(frame);
+    checkEqual(correlator * extrapolator, kernel.correlate(extrapolator, KernelBackend::Direct));
+  }
+  BOOST_TEST(correlator.planCount() == 1); // Shared by the extrapolation methods
+  Raster<double> other({12, 40});
+  other.range();
+  const auto extrapolator = extrapolate<NearestNeighbor>(other);
+  checkEqual(correlator * extrapolator, kernel.correlate(extrapolator, KernelBackend::Direct));
+  BOOST_TEST(correlator.planCount() == 2);
+  correlator.clear();
+  BOOST_TEST(correlator.planCount() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(move_test) {
+  Raster<double> values({3, 3});
+  values.range();
+  const auto kernel = kernelize(values);
+  Raster<double> frame({20, 10});
+  frame.range();
+  const auto extrapolator = extrapolate(frame, 0.);
+  DftCorrelator<double> a(kernel);
+  DftCorrelator<double> b(kernelize(Raster<double>({5, 5}).fill(1)));
+  b * extrapolator;
+  a * extrapolator;
+  b = std::move(a); // Destroys the plans of b
+  BOOST_TEST(b.planCount() == 1);
+  checkEqual(b * extrapolator, kernel.correlate(extrapolator, KernelBackend::Direct));
+  DftCorrelator<double> c(std::move(b));
+  BOOST_TEST(c.planCount() == 1);
+  checkEqual(c * extrapolator, kernel.correlate(extrapolator, KernelBackend::Direct));
+}
+
+BOOST_AUTO_TEST_CASE(dft_shape_test) {
+  const std::vector<float> values(21, 1);
+  const DftCorrelator<float> correlator(values.data(), Box<2>({-3, 2}, {3, 4}));
+  BOOST_TEST((correlator.dftShape({100, 11}) == Position<2>({108, 15}))); // 106 -> 108, 15 -> 15
+}
+
+BOOST_AUTO_TEST_CASE(integer_test) {
+  Raster<int, 3> in({6, 5, 4});
+  in.range(-50);
+  Raster<int, 3> values({3, 3, 2});
+  values.range(-9);
+  const auto kernel = kernelize(values);
+  DftCorrelator<int, 3> correlator(kernel);
+  Raster<int, 3> out(in.shape());
+  correlator.correlateTo(extrapolate(in, 7), out);
+  BOOST_TEST(out == kernel * extrapolate(in, 7)); // Rounded to nearest
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,94 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlTransforms/DistanceTransform.h"
+
+#include <boost/test/unit_test.hpp>
+#include <cstdlib> // rand
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(DistanceTransform_test)
+
+//-----------------------------------------------------------------------------
+
+template <Index P, Index N>
+double bruteForceDistance(const Position<N>& a, const Position<N>& b) {
+  double out = 0;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    const double d = std::abs(a[i] - b[i]);
+    out = P == 1 ? out + d : P == 2 ? out + d * d : std::max(out, d);
+  }
+  return P == 2 ? std::sqrt(out) : out;
+}
+
+template <Index P, Index N>
+void checkTransform(const Raster<int, N>& in) {
+  Raster<Index, N> nearest;
+  ThreadPool pool(3);
+  const auto out = distanceTransform<P>(
+      in,
+      [](auto e) {
+        return e != 0;
+      },
+      nearest,
+      pool);
+  for (const auto& p : in.domain()) {
+    double expected = std::numeric_limits<double>::infinity();
+    for (const auto& q : in.domain()) {
+      if (in[q]) {
+        expected = std::min(expected, bruteForceDistance<P>(p, q));
+      }
+    }
+    BOOST_TEST(out[p] == expected, boost::test_tools::tolerance(1e-12));
+    const auto k = nearest[p];
+    BOOST_REQUIRE(k >= 0);
+    BOOST_TEST(in[k] != 0);
+    Position<N> q(in.dimension());
+    auto r = k;
+    for (Index i = 0; i < in.dimension(); ++i) {
+      q[i] = r % in.length(i);
+      r /= in.length(i);
+    }
+    BOOST_TEST(bruteForceDistance<P>(p, q) == expected, boost::test_tools::tolerance(1e-12));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(random_2d_test) {
+  std::srand(0);
+  Raster<int> in({23, 17});
+  in.generate([]() {
+    return std::rand() % 20 == 0;
+  });
+  checkTransform<1>(in);
+  checkTransform<2>(in);
+  checkTransform<-1>(in);
+}
+
+BOOST_AUTO_TEST_CASE(random_3d_test) {
+  std::srand(1);
+  Raster<int, 3> in({9, 7, 8});
+  in.generate([]() {
+    return std::rand() % 50 == 0;
+  });
+  checkTransform<1>(in);
+  checkTransform<2>(in);
+  checkTransform<-1>(in);
+}
+
+BOOST_AUTO_TEST_CASE(single_feature_test) {
+  Raster<char> in({5, 4});
+  in[{1, 2}] = 1;
+  const auto out = distanceTransform(in);
+  BOOST_TEST((out[{1, 2}] == 0));
+  BOOST_TEST((out[{4, 0}] == std::sqrt(13.)));
+  const auto empty = distanceTransform<1>(Raster<char>({3, 3}));
+  BOOST_TEST(std::isinf(empty[0]));
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
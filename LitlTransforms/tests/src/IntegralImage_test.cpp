@@ -0,0 +1,83 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlTransforms/IntegralImage.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(IntegralImage_test)
+
+//-----------------------------------------------------------------------------
+
+template <typename TRaster>
+double bruteForceSum(const TRaster& in, const Box<TRaster::Dimension>& box, bool squares = false) {
+  double sum = 0;
+  for (const auto& p : box) {
+    if (in.contains(p)) {
+      const double v = in[p];
+      sum += squares ? v * v : v;
+    }
+  }
+  return sum;
+}
+
+BOOST_AUTO_TEST_CASE(box_sum_3d_test) {
+  Raster<int, 3> in({9, 7, 5});
+  in.generate(UniformNoise<int>(-100, 100));
+  ThreadPool pool(4);
+  const auto integral = integrate(in, false, pool);
+  BOOST_TEST((std::is_same<decltype(integral)::Value, std::int64_t>::value));
+  BOOST_TEST(not integral.hasSquares());
+  const std::vector<Box<3>> boxes {
+      in.domain(),
+      {{0, 0, 0}, {0, 0, 0}},
+      {{2, 1, 3}, {6, 5, 4}},
+      {{-3, 2, -1}, {4, 10, 2}}, // Cropped
+      {{10, 0, 0}, {12, 3, 3}}}; // Outside
+  for (const auto& b : boxes) {
+    BOOST_TEST(integral.sum(b) == bruteForceSum(in, b));
+  }
+  BOOST_CHECK_THROW(integral.sumOfSquares(boxes[0]), Exception);
+}
+
+BOOST_AUTO_TEST_CASE(unsigned_mean_and_variance_test) {
+  Raster<unsigned char> in({64, 48});
+  in.generate(UniformNoise<unsigned char>(0, 255));
+  const auto integral = integrate(in, true);
+  BOOST_TEST(integral.hasSquares());
+  const Box<2> box {{10, 20}, {40, 47}};
+  const auto n = double(box.size());
+  const auto mean = bruteForceSum(in, box) / n;
+  const auto variance = bruteForceSum(in, box, true) / n - mean * mean;
+  BOOST_TEST(integral.sum(in.domain()) == bruteForceSum(in, in.domain()));
+  BOOST_TEST(integral.mean(box) == mean, boost::test_tools::tolerance(1e-12));
+  BOOST_TEST(integral.variance(box) == variance, boost::test_tools::tolerance(1e-9));
+}
+
+BOOST_AUTO_TEST_CASE(box_mean_test) {
+  Raster<float> in({31, 17});
+  in.generate(UniformNoise<float>(0, 1));
+  const auto integral = integrate(in);
+  const auto window = Box<2>::fromCenter(3);
+  const auto out = integral.boxMean(window);
+  for (const auto& p : in.domain()) {
+    double sum = 0;
+    Index count = 0;
+    for (const auto& q : window + p) {
+      if (in.contains(q)) {
+        sum += in[q];
+        ++count;
+      }
+    }
+    BOOST_TEST(out[p] == sum / count, boost::test_tools::tolerance(1e-6));
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,9 +2,16 @@
 // This file is part of Litl <github.com/kabasset/Raster>
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
+#include "LitlRaster/StaticRaster.h"
 #include "LitlTransforms/Kernel.h"
 
+#include <atomic>
 #include <boost/test/unit_test.hpp>
+#include <cmath> // abs, floor, lround
+#include <complex>
+#include <mutex>
+#include <random>
+#include <sstream>
 
 using namespace Litl;
 
@@ -24,6 +31,494 @@ BOOST_AUTO_TEST_CASE(coverage_test) {
   }
 }
 
+template <typename T>
+void checkBruteForce(const Position<3>& shape, const Box<3>& window) {
+  Raster<T, 3> in(shape);
+  in.range(-10);
+  Raster<T, 3> values(window.shape());
+  values.range(-3);
+  const auto k = kernelize(values.data(), window);
+  const auto extrapolator = extrapolate<NearestNeighbor>(in);
+  const auto out = k.correlate(extrapolator, KernelBackend::Direct);
+  for (const auto& p : in.domain()) {
+    T expected = 0;
+    for (const auto& q : window) {
+      expected += values[q - window.front()] * extrapolator[p + q];
+    }
+    BOOST_TEST(out[p] == expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(blocked_3d_test) {
+  // Row lengths which are not multiples of the block width
+  checkBruteForce<int>({37, 6, 5}, Box<3>({-1, -2, -1}, {2, 1, 1}));
+  checkBruteForce<double>({23, 7, 4}, Box<3>({-2, -1, 0}, {2, 1, 2}));
+  checkBruteForce<std::int64_t>({3, 4, 5}, Box<3>({0, 0, -1}, {0, 2, 1}));
+}
+
+BOOST_AUTO_TEST_CASE(small_kernels_test) {
+  // Shapes which are specialized at compile time
+  checkBruteForce<float>({41, 5, 3}, Box<3>({-1, 0, 0}, {1, 0, 0}));
+  checkBruteForce<int>({19, 6, 2}, Box<3>({-2, 0, 0}, {2, 0, 0}));
+  checkBruteForce<double>({37, 9, 2}, Box<3>({-1, -1, 0}, {1, 1, 0}));
+  checkBruteForce<int>({35, 8, 3}, Box<3>({-2, -2, 0}, {2, 2, 0}));
+  checkBruteForce<float>({43, 6, 5}, Box<3>({-1, -1, -1}, {1, 1, 1}));
+}
+
+BOOST_AUTO_TEST_CASE(static_raster_test) {
+  StaticRaster<float, 7, 5> stamp;
+  stamp.range();
+  const auto k = kernelize(Raster<float>({3, 3}).range());
+  Raster<float> raster(stamp.shape());
+  raster.range();
+  const auto expected = k * extrapolate(raster, 1.F);
+  BOOST_TEST(k * extrapolate<OutOfBoundsConstant<float>>(stamp, 1.F) == expected);
+  StaticRaster<float, 7, 5> out;
+  k.correlateTo(extrapolate<NearestNeighbor>(stamp), out);
+  BOOST_TEST(out.view() == k * extrapolate<NearestNeighbor>(raster));
+}
+
+BOOST_AUTO_TEST_CASE(wide_accumulator_test) {
+  Raster<std::int16_t> in({20, 3});
+  in.fill(30000);
+  const auto k = kernelize(Raster<std::int16_t>({3, 1}).fill(1));
+  Raster<std::int32_t> out(in.shape());
+  k.correlateTo(extrapolate(in, std::int16_t(0)), out);
+  BOOST_TEST((out[{10, 1}] == 90000)); // Would overflow with 16-bit accumulators
+}
+
+BOOST_AUTO_TEST_CASE(narrow_accumulator_test) {
+  const std::vector<std::int16_t> binomial {1, 2, 1, 2, 4, 2, 1, 2, 1};
+  const auto accumulatorSize = [&](auto in, std::size_t size, Index shift) {
+    std::size_t out = 0;
+    Internal::withIntegerAccumulator<decltype(in)>(binomial.data(), size, shift, [&](auto accumulator) {
+      out = sizeof(accumulator);
+    });
+    return out;
+  };
+  BOOST_TEST(accumulatorSize(std::uint8_t(), 9, 4) == 2);
+  BOOST_TEST(accumulatorSize(std::uint8_t(), 9, 16) == 4);
+  BOOST_TEST(accumulatorSize(std::uint16_t(), 9, 0) == 4);
+  BOOST_TEST(accumulatorSize(std::int32_t(), 9, 0) == 8);
+  BOOST_TEST(accumulatorSize(float(), 9, 0) == 8);
+}
+
+BOOST_AUTO_TEST_CASE(fixed_point_test) {
+  Raster<std::uint8_t> in({37, 5});
+  std::minstd_rand generator(42);
+  for (auto& e : in) {
+    e = std::uint8_t(generator() % 256);
+  }
+  const auto extrapolator = extrapolate<NearestNeighbor>(in);
+  auto k = kernelize(Raster<std::int16_t>({3, 3}, {1, 2, 1, 2, 4, 2, 1, 2, 1}));
+  BOOST_TEST(k.setFractionBits(4).fractionBits() == 4);
+  Raster<std::uint8_t> out(in.shape());
+  k.correlateTo(extrapolator, out);
+  for (const auto& p : in.domain()) {
+    long sum = 0;
+    for (const auto& q : k.window()) {
+      sum += k.raster()[q - k.window().front()] * extrapolator[p + q];
+    }
+    BOOST_TEST(out[p] == (sum + 8) / 16);
+  }
+  BOOST_CHECK_THROW(k.correlate(extrapolator, KernelBackend::Dft), Exception);
+  BOOST_CHECK_THROW(kernelize(Raster<float>({3, 3})).setFractionBits(1), Exception);
+}
+
+BOOST_AUTO_TEST_CASE(saturation_test) {
+  Raster<std::uint8_t> in({20, 3});
+  in.fill(10);
+  in[{10, 1}] = 250;
+  const auto k = kernelize(Raster<int>({3, 3}, {0, -1, 0, -1, 5, -1, 0, -1, 0}));
+  Raster<std::uint8_t> out(in.shape());
+  k.correlateTo(extrapolate<NearestNeighbor>(in), out);
+  BOOST_TEST((out[{0, 0}] == 10));
+  BOOST_TEST((out[{10, 1}] == 255)); // 1210
+  BOOST_TEST((out[{9, 1}] == 0)); // -240
+  BOOST_TEST((out[{10, 0}] == 0));
+}
+
+BOOST_AUTO_TEST_CASE(workspace_test) {
+  Raster<int> in({5, 4});
+  in.range();
+  auto k = kernelize(Raster<int>({3, 3}).range());
+  const auto extrapolator = extrapolate(in, 0);
+  const auto expected = k * extrapolator;
+  Workspace workspace;
+  Raster<int> out(in.shape());
+  k.correlateTo(extrapolator, out, workspace);
+  BOOST_TEST(out == expected);
+  k.correlateTo(extrapolator, out, workspace);
+  BOOST_TEST(out == expected);
+  BOOST_TEST(workspace.allocationCount() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(padded_test) {
+  Raster<int, 3> in({6, 5, 4});
+  in.range();
+  Raster<int, 3> values({3, 2, 3});
+  values.range(-5);
+  const auto k = kernelize(values);
+  const auto extrapolator = extrapolate<Periodic>(in);
+  const auto out = k * pad(extrapolator, k.window());
+  for (const auto& p : in.domain()) {
+    int expected = 0;
+    for (const auto& q : k.window()) {
+      expected += values[q - k.window().front()] * extrapolator[p + q];
+    }
+    BOOST_TEST(out[p] == expected);
+  }
+  BOOST_CHECK_THROW(k * pad(extrapolator, Box<3>::fromCenter(0)), Exception);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_direct_test) {
+  Raster<int, 3> in({41, 23, 17});
+  in.range(-3000);
+  for (const auto& window : {Box<3>({-2, -1, -3}, {3, 1, 2}), Box<3>({1, 2, 0}, {4, 5, 3}), Box<3>::fromCenter(12)}) {
+    Raster<int, 3> values(window.shape());
+    values.range(-20);
+    const auto k = kernelize(values.data(), window);
+    const auto extrapolator = extrapolate<NearestNeighbor>(in);
+    Raster<int, 3> expected(in.shape());
+    Workspace workspace;
+    k.correlateTo(extrapolator, expected, workspace);
+    for (std::size_t threads : {1, 3, 8}) {
+      ThreadPool pool(threads);
+      Raster<int, 3> out(in.shape());
+      k.correlateTo(extrapolator, out, pool);
+      BOOST_TEST(out == expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(arena_direct_test) {
+  Raster<int, 2> in({300, 200});
+  in.range(-30000);
+  Raster<int, 2> values({9, 9});
+  values.range(-40);
+  const auto k = kernelize(values);
+  const auto extrapolator = extrapolate<NearestNeighbor>(in);
+  Raster<int, 2> expected(in.shape());
+  Workspace workspace(nullptr);
+  k.correlateTo(extrapolator, expected, workspace);
+  Arena arena;
+  {
+    ArenaScope scope(arena);
+    Raster<int, 2> out(in.shape());
+    k.correlateTo(extrapolator, out, KernelBackend::Direct); // Large enough to be parallelized out of an arena
+    BOOST_TEST(out == expected);
+  }
+  BOOST_TEST(arena.usedBytes() > 0);
+  ThreadPool pool(2);
+  std::atomic<int> mismatches(0);
+  pool.run(2, [&](std::size_t) { // Nested, hence sequential
+    Raster<int, 2> out(in.shape());
+    k.correlateTo(extrapolator, out, KernelBackend::Direct);
+    mismatches += out != expected;
+  });
+  BOOST_TEST(mismatches == 0);
+}
+
+template <typename TExtrapolator>
+void checkBackends(const Kernel<float>& k, const TExtrapolator& in, bool separable) {
+  const auto expected = k.correlate(in, KernelBackend::Direct);
+  const auto dft = k.correlate(in, KernelBackend::Dft);
+  for (const auto& p : expected.domain()) {
+    BOOST_TEST(dft[p] == expected[p], boost::test_tools::tolerance(1.e-3F));
+  }
+  if (separable) {
+    const auto sep = k.correlate(in, KernelBackend::Separable);
+    for (const auto& p : expected.domain()) {
+      BOOST_TEST(sep[p] == expected[p], boost::test_tools::tolerance(1.e-3F));
+    }
+  } else {
+    BOOST_CHECK_THROW(k.correlate(in, KernelBackend::Separable), Exception);
+  }
+
+  // Integral outputs are rounded the same way
+  std::vector<KernelBackend> backends {KernelBackend::Direct, KernelBackend::Dft, KernelBackend::TiledDft};
+  if (separable) {
+    backends.push_back(KernelBackend::Separable);
+  }
+  for (auto backend : backends) {
+    Raster<int> out(in.shape());
+    k.correlateTo(in, out, backend);
+    for (const auto& p : expected.domain()) {
+      const auto value = expected[p];
+      if (std::abs(value - std::floor(value) - .5F) > .01F) { // Far from ties
+        BOOST_TEST(out[p] == std::lround(value));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(integral_output_rounding_test) {
+  const auto in = Raster<int>({16, 12}).fill(1);
+  const auto k = kernelize(Raster<float>({3, 3}).fill(.3F));
+  for (auto backend : {KernelBackend::Direct, KernelBackend::Separable, KernelBackend::Dft}) {
+    Raster<int> out(in.shape());
+    k.correlateTo(extrapolate<NearestNeighbor>(in), out, backend);
+    for (const auto& e : out) {
+      BOOST_TEST(e == 3); // 2.7
+    }
+  }
+  Raster<std::uint8_t> saturated(in.shape());
+  kernelize(Raster<float>({3, 3}).fill(-100.F)).correlateTo(extrapolate<NearestNeighbor>(in), saturated);
+  BOOST_TEST((saturated[{0, 0}] == 0));
+}
+
+BOOST_AUTO_TEST_CASE(backends_test) {
+  Raster<float> in({37, 23});
+  in.range(-100);
+  Raster<float> separable({5, 7});
+  for (const auto& p : separable.domain()) {
+    separable[p] = (p[0] - 1.5F) * (p[1] * p[1] + 1.F);
+  }
+  Raster<float> any({6, 3});
+  any.range(-8);
+  for (const auto& k : {kernelize(separable), kernelize(separable, {4, -1}), kernelize(any, {0, 2})}) {
+    const bool isSeparable = std::size_t(k.window().size()) == separable.size();
+    BOOST_TEST(k.isSeparable() == isSeparable);
+    checkBackends(k, extrapolate(in, 1.F), isSeparable);
+    checkBackends(k, extrapolate<NearestNeighbor>(in), isSeparable);
+    checkBackends(k, extrapolate<Periodic>(in), isSeparable);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(low_rank_test) {
+  Raster<float> values({15, 11});
+  for (const auto& p : values.domain()) {
+    const auto x = p[0] - 7.F;
+    const auto y = p[1] - 5.F;
+    values[p] = std::exp(-(x * x + y * y) / 8.F) - .5F * std::exp(-(x * x + 2.F * y * y) / 32.F); // Rank 2
+  }
+  auto k = kernelize(values);
+  const auto terms = k.separate();
+  BOOST_TEST(terms.size() == 2);
+  for (const auto& p : values.domain()) {
+    float sum = 0;
+    for (const auto& t : terms) {
+      BOOST_TEST(t[0].origin() == 7);
+      BOOST_TEST(t[1].origin() == 5);
+      sum += t[0][p[0]] * t[1][p[1]];
+    }
+    BOOST_TEST(sum == values[p], boost::test_tools::tolerance(1.e-5F));
+  }
+  Raster<float> in({80, 60});
+  in.range(-100);
+  BOOST_TEST(k.selectBackend({512, 512}, 1) == KernelBackend::Separable);
+  checkBackends(k, extrapolate<NearestNeighbor>(in), true);
+
+  // Nearly low-rank
+  std::minstd_rand generator;
+  for (auto& v : values) {
+    v += 1.e-4F * std::generate_canonical<float, 24>(generator);
+  }
+  k = kernelize(values);
+  BOOST_TEST(k.separate().size() == 11);
+  BOOST_CHECK_THROW(k.correlate(extrapolate(in, 0.F), KernelBackend::Separable), Exception);
+  k.setSeparationTolerance(1.e-3);
+  BOOST_TEST(k.separate(k.separationTolerance()).size() == 2);
+  const auto expected = k.correlate(extrapolate(in, 0.F), KernelBackend::Direct);
+  const auto approx = k.correlate(extrapolate(in, 0.F), KernelBackend::Separable);
+  float error = 0;
+  for (const auto& p : expected.domain()) {
+    error = std::max(error, std::abs(approx[p] - expected[p]));
+  }
+  BOOST_TEST(error < 1.F);
+}
+
+template <typename TRaster, typename TExtrapolator>
+void checkTiled(const Kernel<double, 2>& k, const TExtrapolator& in, const Position<2>& tileShape) {
+  const auto expected = k.correlate(in, KernelBackend::Direct);
+  TRaster out(in.shape());
+  ThreadPool pool(3);
+  k.correlateTiledTo(in, out, tileShape, pool);
+  for (const auto& p : expected.domain()) {
+    BOOST_TEST(out[p] == expected[p], boost::test_tools::tolerance(1.e-9));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(tiled_dft_test) {
+  Raster<double> in({53, 41});
+  in.range(-500);
+  Raster<double> values({7, 4});
+  values.range(-9);
+  for (const auto& k : {kernelize(values), kernelize(values, {-2, 1}), kernelize(values, {8, 5})}) {
+    // Blocks which do not divide the shape, interior and border tiles
+    checkTiled<Raster<double>>(k, extrapolate(in, 3.), {16, 12});
+    checkTiled<Raster<double>>(k, extrapolate<NearestNeighbor>(in), {20, 9});
+    checkTiled<Raster<double>>(k, extrapolate<Periodic>(in), {64, 64}); // Single tile
+  }
+  const auto k = kernelize(values);
+  BOOST_CHECK_THROW(checkTiled<Raster<double>>(k, extrapolate(in, 0.), {6, 12}), Exception);
+}
+
+/**
+ * @brief Extrapolation method which throws, to check the cleanup of the tiled DFT.
+ */
+struct ThrowingExtrapolation {
+  template <typename TRaster>
+  const typename TRaster::Value& at(TRaster& raster, const Position<TRaster::Dimension>& position) const {
+    if (not raster.contains(position)) {
+      throw Exception("Out of bounds");
+    }
+    return raster[position];
+  }
+};
+
+BOOST_AUTO_TEST_CASE(tiled_dft_exception_test) {
+  Raster<double> in({53, 41});
+  in.range();
+  const auto k = kernelize(Raster<double>({5, 5}).range());
+  Raster<double> out(in.shape());
+  ThreadPool pool(4);
+  BOOST_CHECK_THROW(k.correlateTiledTo(extrapolate<ThrowingExtrapolation>(in), out, {16, 16}, pool), Exception);
+  checkTiled<Raster<double>>(k, extrapolate(in, 0.), {16, 16}); // Plans were released, the planner is unlocked
+}
+
+BOOST_AUTO_TEST_CASE(tile_shape_test) {
+  const auto window3d = Box<3>::fromCenter(1);
+  BOOST_TEST((Internal::dftTileShape(Position<3>({400, 400, 400}), window3d) == Position<3>({40, 40, 40})));
+  const auto window2d = Box<2>::fromCenter(50);
+  BOOST_TEST((Internal::dftTileShape(Position<2>({4096, 300}), window2d) == Position<2>({405, 400})));
+}
+
+BOOST_AUTO_TEST_CASE(integer_dft_test) {
+  Raster<int, 3> in({9, 8, 7});
+  in.range(-200);
+  Raster<int, 3> values({3, 4, 2});
+  values.range(-11);
+  const auto k = kernelize(values);
+  const auto extrapolator = extrapolate<Periodic>(in);
+  BOOST_TEST(k.selectBackend(in.shape()) == KernelBackend::Direct);
+  BOOST_TEST(k.correlate(extrapolator, KernelBackend::Dft) == k * extrapolator); // Exact after rounding
+}
+
+BOOST_AUTO_TEST_CASE(auto_selection_test) {
+  const Position<2> shape {512, 512};
+  BOOST_TEST(kernelize(Raster<float>({3, 3}).range()).selectBackend(shape) == KernelBackend::Direct);
+  BOOST_TEST(kernelize(Raster<float>({31, 31}).fill(1)).selectBackend(shape, 1) == KernelBackend::Separable);
+  BOOST_TEST(kernelize(Raster<float>({31, 31}).fill(1)).selectBackend(shape, 64) == KernelBackend::Direct);
+  Raster<float> noise({61, 61});
+  std::minstd_rand generator;
+  for (auto& v : noise) {
+    v = std::generate_canonical<float, 24>(generator); // Full rank
+  }
+  const auto large = kernelize(noise).selectBackend(shape);
+  BOOST_TEST((large == KernelBackend::Dft || large == KernelBackend::TiledDft));
+  BOOST_TEST(kernelize(Raster<float>({61, 61}).range()).selectBackend(shape, 1) == KernelBackend::Separable);
+  BOOST_TEST(kernelize(Raster<int>({61, 61}).range()).selectBackend(shape) == KernelBackend::Direct);
+}
+
+BOOST_AUTO_TEST_CASE(log_test) {
+  std::ostringstream oss;
+  logKernelBackends(&oss);
+  Raster<double> in({40, 30});
+  const auto k = kernelize(Raster<double>({3, 3}).range());
+  k * extrapolate(in, 0.);
+  k.correlate(extrapolate(in, 0.), KernelBackend::Dft);
+  logKernelBackends(nullptr);
+  k * extrapolate(in, 0.);
+  const auto log = oss.str();
+  BOOST_TEST(log.find("shape 40x30, window 3x3 -> Direct (direct: ") != std::string::npos);
+  BOOST_TEST(log.find("-> Dft (forced)") != std::string::npos);
+  BOOST_TEST(std::count(log.begin(), log.end(), '\n') == 2);
+}
+
+BOOST_AUTO_TEST_CASE(log_without_planner_lock_test) {
+  std::ostringstream oss;
+  logKernelBackends(&oss);
+  Raster<double> in({40, 30});
+  const auto k = kernelize(Raster<double>({3, 3}).range());
+  {
+    std::lock_guard<std::mutex> planning(Internal::dftPlannerMutex()); // As while another thread plans a DFT
+    k.correlate(extrapolate(in, 0.), KernelBackend::Direct);
+  }
+  logKernelBackends(nullptr);
+  BOOST_TEST(oss.str().find("-> Direct (forced)") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(convolve_test) {
+  Raster<double> in({11, 7});
+  in.range();
+  Raster<double> values({4, 3});
+  values.range(1);
+  const auto k = kernelize(values, {1, 2});
+  const auto extrapolator = extrapolate<NearestNeighbor>(in);
+  const auto direct = k.convolve(extrapolator, KernelBackend::Direct);
+  const auto dft = k.convolve(extrapolator, KernelBackend::Dft);
+  for (const auto& p : in.domain()) {
+    double expected = 0;
+    for (const auto& q : k.window()) {
+      expected += values[q - k.window().front()] * extrapolator[p - q];
+    }
+    BOOST_TEST(direct[p] == expected, boost::test_tools::tolerance(1.e-12));
+    BOOST_TEST(dft[p] == expected, boost::test_tools::tolerance(1.e-9));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(separation_cache_test) {
+  Raster<double> in({13, 9});
+  in.range();
+  const auto extrapolator = extrapolate<NearestNeighbor>(in);
+  Raster<double> values({4, 3});
+  for (const auto& p : values.domain()) {
+    values[p] = (p[0] + 1.) * (p[1] * p[1] + 2.); // Rank 1, asymmetric
+  }
+  auto k = kernelize(values, {1, 2});
+  BOOST_TEST(k.separate().size() == 1);
+  const auto flipped = k.flip(); // Shares the decomposition
+  const auto restored = flipped.flip();
+  const auto direct = k.convolve(extrapolator, KernelBackend::Direct);
+  const auto separable = k.convolve(extrapolator, KernelBackend::Separable);
+  const auto correlated = k.correlate(extrapolator, KernelBackend::Direct);
+  const auto twice = restored.correlate(extrapolator, KernelBackend::Separable);
+  for (const auto& p : in.domain()) {
+    BOOST_TEST(separable[p] == direct[p], boost::test_tools::tolerance(1.e-9));
+    BOOST_TEST(twice[p] == correlated[p], boost::test_tools::tolerance(1.e-9));
+  }
+
+  k.raster()[{0, 0}] += 1; // Full rank
+  BOOST_CHECK_THROW(k.correlate(extrapolator, KernelBackend::Separable), Exception);
+  const Position<2> center {6, 4};
+  const auto unchanged = flipped.flip().correlate(extrapolator, KernelBackend::Separable);
+  BOOST_TEST(unchanged[center] == correlated[center], boost::test_tools::tolerance(1.e-9));
+  k.setSeparationTolerance(.2);
+  BOOST_TEST(k.separate(k.separationTolerance()).size() == 1);
+  BOOST_CHECK_NO_THROW(k.correlate(extrapolator, KernelBackend::Separable));
+}
+
+BOOST_AUTO_TEST_CASE(separation_cache_view_test) {
+  Raster<double> in({13, 9});
+  in.range();
+  const auto extrapolator = extrapolate<NearestNeighbor>(in);
+  Raster<double> values({4, 3});
+  for (const auto& p : values.domain()) {
+    values[p] = (p[0] + 1.) * (p[1] * p[1] + 2.); // Rank 1
+  }
+  auto k = kernelize(values);
+  auto view = k.raster(); // Kept across correlations
+  k.correlate(extrapolator, KernelBackend::Separable);
+  view[{0, 0}] *= 2; // Rank 2
+  BOOST_CHECK_THROW(k.correlate(extrapolator, KernelBackend::Separable), Exception);
+  BOOST_CHECK_THROW(k.flip().correlate(extrapolator, KernelBackend::Separable), Exception);
+  view[{0, 0}] /= 2;
+  const auto direct = k.correlate(extrapolator, KernelBackend::Direct);
+  const auto separable = k.correlate(extrapolator, KernelBackend::Separable);
+  for (const auto& p : in.domain()) {
+    BOOST_TEST(separable[p] == direct[p], boost::test_tools::tolerance(1.e-9));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(complex_dft_throws_test) {
+  using Complex = std::complex<double>;
+  Raster<Complex> in({8, 8});
+  const auto k = kernelize(Raster<Complex>({3, 3}).fill(Complex(1, 1)));
+  BOOST_TEST(k.selectBackend(in.shape()) == KernelBackend::Direct);
+  BOOST_CHECK_THROW(k.correlate(extrapolate(in, Complex()), KernelBackend::Dft), Exception);
+}
+
 //-----------------------------------------------------------------------------
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,140 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlTransforms/Labeling.h"
+
+#include <boost/test/unit_test.hpp>
+#include <cstdlib> // rand
+#include <deque>
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(Labeling_test)
+
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Label by flood-filling, in storage order.
+ */
+template <Index N>
+Raster<Index, N> floodFill(const Raster<int, N>& in, Index order) {
+  Raster<Index, N> out(in.shape());
+  const auto neighborhood = Box<N>::fromCenter(1);
+  Index count = 0;
+  for (const auto& p : in.domain()) {
+    if (in[p] == 0 || out[p] != 0) {
+      continue;
+    }
+    out[p] = ++count;
+    std::deque<Position<N>> queue {p};
+    while (not queue.empty()) {
+      const auto q = queue.front();
+      queue.pop_front();
+      for (const auto& o : neighborhood) {
+        Index nonzeros = 0;
+        for (auto i : o) {
+          nonzeros += (i != 0);
+        }
+        const auto r = q + o;
+        if (nonzeros == 0 || nonzeros > order || not in.contains(r) || in[r] == 0 || out[r] != 0) {
+          continue;
+        }
+        out[r] = count;
+        queue.push_back(r);
+      }
+    }
+  }
+  return out;
+}
+
+template <Index N>
+void checkLabeling(const Raster<int, N>& in, Connectivity connectivity, Index order) {
+  const auto expected = floodFill(in, order);
+  ThreadPool pool(4);
+  for (Index grainSize : {0L, 7L, 100L, 1L << 20}) {
+    const auto out = label(in, connectivity, false, grainSize, pool);
+    BOOST_TEST(out.labels == expected);
+    BOOST_TEST(out.count == *std::max_element(expected.begin(), expected.end()));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(random_2d_test) {
+  std::srand(0);
+  Raster<int> in({37, 29});
+  in.generate([]() {
+    return std::rand() % 3 == 0;
+  });
+  checkLabeling(in, Connectivity::Face, 1);
+  checkLabeling(in, Connectivity::Vertex, 2);
+}
+
+BOOST_AUTO_TEST_CASE(random_3d_test) {
+  std::srand(1);
+  Raster<int, 3> in({11, 9, 13});
+  in.generate([]() {
+    return std::rand() % 4 == 0;
+  });
+  checkLabeling(in, Connectivity::Face, 1);
+  checkLabeling(in, Connectivity::Edge, 2);
+  checkLabeling(in, Connectivity::Vertex, 3);
+}
+
+BOOST_AUTO_TEST_CASE(statistics_test) {
+  Raster<float> in({6, 5});
+  in[{1, 1}] = 1;
+  in[{2, 1}] = 3;
+  in[{2, 2}] = 4;
+  in[{5, 4}] = 2;
+  in[{0, 4}] = -1; // Not in the foreground
+  const auto out = label(
+      in,
+      [](auto e) {
+        return e > 0;
+      },
+      Connectivity::Face,
+      true,
+      4);
+  BOOST_TEST(out.count == 2);
+  BOOST_TEST(out.components.size() == 2);
+  const auto& c = out.components[0];
+  BOOST_TEST(c.label == 1);
+  BOOST_TEST(c.area == 3);
+  BOOST_TEST((c.box == Box<2>({1, 1}, {2, 2})));
+  BOOST_TEST(c.flux == 8);
+  BOOST_TEST(c.center[0] == 5. / 3.);
+  BOOST_TEST(c.center[1] == 4. / 3.);
+  BOOST_TEST(c.centroid[0] == 15. / 8.);
+  BOOST_TEST(c.centroid[1] == 12. / 8.);
+  const auto& d = out.components[1];
+  BOOST_TEST(d.area == 1);
+  BOOST_TEST((d.box == Box<2>({5, 4}, {5, 4})));
+  BOOST_TEST((out.labels[{5, 4}] == 2));
+  BOOST_TEST((out.labels[{0, 4}] == 0));
+}
+
+BOOST_AUTO_TEST_CASE(mask_test) {
+  Raster<float> image({8, 6});
+  image.range();
+  Raster<unsigned char> mask(image.shape());
+  for (std::size_t i = 0; i < image.size(); ++i) {
+    mask[i] = (image[i] < 3 || image[i] > 40);
+  }
+  const auto predicated = label(
+      image,
+      [](auto e) {
+        return e < 3 || e > 40;
+      },
+      Connectivity::Vertex);
+  const auto masked = label(mask, Connectivity::Vertex, true);
+  BOOST_TEST(masked.labels == predicated.labels);
+  BOOST_TEST(masked.count == 2);
+  BOOST_TEST(masked.components[1].area == 7);
+  BOOST_TEST(masked.components[1].flux == 7);
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,7 +4,9 @@
 
 #include "LitlTransforms/LineKernel.h"
 
+#include <algorithm> // max, min
 #include <boost/test/unit_test.hpp>
+#include <cstdint> // int16_t, int64_t
 
 using namespace Litl;
 
@@ -14,8 +16,114 @@ BOOST_AUTO_TEST_SUITE(LineKernel_test)
 
 //-----------------------------------------------------------------------------
 
-BOOST_AUTO_TEST_CASE(FIXME_test) {
-  // FIXME
+BOOST_AUTO_TEST_CASE(sampled_correlation_test) {
+  const LineKernel<int> kernel({1, 10, 100, 1000}, 1);
+  std::vector<int> data(22, 0);
+  for (std::size_t i = 0; i < data.size(); i += 2) { // Stride 2
+    data[i] = i / 2 + 1;
+  }
+  for (Index step : {1, 2, 3, 7}) {
+    const DataSamples<const int> in {data.data(), 11, {0, 10, step}, 2};
+    std::vector<int> values(in.count());
+    DataSamples<int> out {values.data(), values.size()};
+    kernel.correlate(in, out);
+    for (std::size_t j = 0; j < values.size(); ++j) {
+      const Index i = j * step;
+      int expected = 0;
+      for (Index k = 0; k < 4; ++k) {
+        const auto n = i + k - 1;
+        if (n >= 0 && n < 11) {
+          expected += kernel[k] * data[n * 2];
+        }
+      }
+      BOOST_TEST(values[j] == expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(interleaved_correlation_test) {
+  Raster<std::int16_t, 2> in({37, 23}); // More lines than a block, and a remainder
+  in.range(-400);
+  const LineKernel<int> kernel({1, -2, 300, -4, 5}, 3);
+  const auto width = in.shape()[0];
+  for (Index step : {1, 2, 5}) {
+    const IndexSampling sampling {1, 22, step};
+    Raster<std::int16_t, 2> out({width, Index(sampling.size())});
+    const DataSamples<const std::int16_t> lines {in.data(), 23, sampling, width};
+    DataSamples<std::int16_t> outLines {out.data(), std::size_t(out.shape()[1]), {}, width};
+    kernel.correlate(lines, outLines, width);
+    for (Index x = 0; x < width; ++x) {
+      const DataSamples<const std::int16_t> line {&in[{x, 0}], 23, sampling, width};
+      std::vector<std::int16_t> values(line.count());
+      DataSamples<std::int16_t> expected {values.data(), values.size()};
+      kernel.correlate(line, expected);
+      for (std::size_t j = 0; j < values.size(); ++j) {
+        BOOST_TEST((out[{x, Index(j)}] == values[j]));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(axis_correlation_test) {
+  Raster<int, 3> in({13, 5, 600}); // Lines longer and shorter than the kernel, slices larger than a block
+  in.range(-100);
+  for (const auto& kernel : {LineKernel<int>({1, 10, 100, 1000}, 1), LineKernel<int>({1, -2, 3, -4, 5, -6, 7}, 6)}) {
+    for (Index axis = 0; axis < 3; ++axis) {
+      Raster<int, 3> out(in.shape());
+      kernel.correlateAlong(in, out, axis);
+      const auto length = in.shape()[axis];
+      const auto stride = shapeStride(in.shape(), axis);
+      auto lines = in.domain();
+      lines.project(axis);
+      for (const auto& p : lines) {
+        const DataSamples<const int> line {&in[p], std::size_t(length), {}, stride};
+        std::vector<int> values(length);
+        DataSamples<int> expected {values.data(), values.size()};
+        kernel.correlate(line, expected);
+        for (Index i = 0; i < length; ++i) {
+          auto q = p;
+          q[axis] = i;
+          BOOST_TEST(out[q] == values[i]);
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(axis_saturation_test) {
+  Raster<std::int16_t, 3> in({40, 3, 40}); // Cropped, blocked and interleaved paths
+  in.range(-30000);
+  const LineKernel<int> kernel({3, -1, 2}, 1);
+  for (Index axis = 0; axis < 3; ++axis) {
+    Raster<std::int16_t, 3> out(in.shape());
+    kernel.correlateAlong(in, out, axis);
+    for (const auto& p : in.domain()) {
+      std::int64_t sum = 0;
+      for (Index k = 0; k < 3; ++k) {
+        auto q = p;
+        q[axis] += k - 1;
+        if (q[axis] >= 0 && q[axis] < in.shape()[axis]) {
+          sum += std::int64_t(kernel[k]) * in[q];
+        }
+      }
+      const auto expected = std::max<std::int64_t>(std::min<std::int64_t>(sum, 32767), -32768);
+      BOOST_TEST(out[p] == expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(axis_rounding_test) {
+  Raster<int, 2> in({40, 40});
+  in.fill(2);
+  const LineKernel<float> kernel({.3F, .3F, .3F}, 1);
+  for (Index axis = 0; axis < 2; ++axis) {
+    Raster<int, 2> out(in.shape());
+    kernel.correlateAlong(in, out, axis);
+    for (const auto& p : in.domain()) {
+      const auto cropped = p[axis] == 0 || p[axis] == 39;
+      BOOST_TEST(out[p] == (cropped ? 1 : 2)); // 1.2 and 1.8 are rounded to nearest
+    }
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -25,6 +25,35 @@ BOOST_AUTO_TEST_CASE(constant0_3x3_test) {
   BOOST_TEST(out.container() == expected);
 }
 
+BOOST_AUTO_TEST_CASE(workspace_test) {
+  Raster<int, 2> in({5, 4});
+  in.range();
+  MedianFilter<int, 2> filter;
+  const auto extra = extrapolate(in, 0);
+  const auto expected = filter.apply(extra);
+  Workspace workspace;
+  Raster<int, 2> out(in.shape());
+  for (Index y = 0; y < in.length(1); ++y) {
+    filter.applyTo(extra, out, Box<2>({0, y}, {in.length(0) - 1, y}), workspace);
+  }
+  BOOST_TEST(out == expected);
+  BOOST_TEST(workspace.allocationCount() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(arena_scratch_test) {
+  Raster<int, 2> in({4, 3});
+  in.range();
+  MedianFilter<int, 2> filter;
+  const auto extra = extrapolate(in, 0);
+  const auto expected = filter.apply(extra);
+  Arena arena;
+  ArenaScope scope(arena);
+  ArenaRaster<int, 2> out(in.shape());
+  filter.applyTo(extra, out, out.domain());
+  BOOST_TEST(out == expected);
+  BOOST_TEST(arena.usedBytes() >= (in.size() + 9) * sizeof(int));
+}
+
 //-----------------------------------------------------------------------------
 
 BOOST_AUTO_TEST_SUITE_END()
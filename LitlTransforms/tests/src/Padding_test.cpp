@@ -0,0 +1,66 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlTransforms/MedianFilter.h"
+#include "LitlTransforms/Padding.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(Padding_test)
+
+//-----------------------------------------------------------------------------
+
+template <typename TExtrapolator>
+void checkPadding(const TExtrapolator& extrapolator, const Box<3>& margin) {
+  const auto padded = pad(extrapolator, margin);
+  BOOST_TEST(padded.shape() == extrapolator.shape());
+  BOOST_TEST(padded.paddedDomain().front() == margin.front());
+  BOOST_TEST(padded.raster().shape() == extrapolator.shape() + margin.back() - margin.front());
+  for (const auto& p : padded.paddedDomain()) {
+    BOOST_TEST(padded[p] == extrapolator[p]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(extrapolators_test) {
+  Raster<int, 3> in({5, 4, 3});
+  in.range(1);
+  const Position<3> front {-2, -1, 0};
+  const Position<3> back {1, 3, 2};
+  const Box<3> margin(front, back);
+  checkPadding(extrapolate(in, -1), margin);
+  checkPadding(extrapolate<NearestNeighbor>(in), margin);
+  checkPadding(extrapolate<Periodic>(in), margin);
+}
+
+BOOST_AUTO_TEST_CASE(off_origin_margin_test) {
+  Raster<int, 3> in({5, 4, 3});
+  in.range(1);
+  const auto extrapolator = extrapolate<Periodic>(in);
+  const Box<3> window({1, -3, -2}, {2, -1, 1}); // Does not contain the origin along axes 0 and 1
+  const auto padded = pad(extrapolator, window);
+  BOOST_TEST(padded.margin().front() == Position<3>({0, -3, -2}));
+  BOOST_TEST(padded.margin().back() == Position<3>({2, 0, 1}));
+  checkPadding(extrapolator, padded.margin());
+  for (const auto& p : padded.paddedDomain()) {
+    BOOST_TEST(padded[p] == extrapolator[p]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(median_filter_test) {
+  Raster<float> in({6, 5});
+  in.range();
+  MedianFilter<float, 2> filter(1);
+  const auto extrapolator = extrapolate<NearestNeighbor>(in);
+  const auto expected = filter.apply(extrapolator);
+  const auto out = filter.apply(pad(extrapolator, Box<2>::fromCenter(1)));
+  BOOST_TEST(out == expected);
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
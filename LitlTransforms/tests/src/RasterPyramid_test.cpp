@@ -0,0 +1,106 @@
+// @copyright 2022, Antoine Basset (CNES)
+// This file is part of Litl <github.com/kabasset/Raster>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "LitlTransforms/RasterPyramid.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Litl;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(RasterPyramid_test)
+
+//-----------------------------------------------------------------------------
+
+template <typename TRaster>
+Raster<double, 2> bruteForceDecimate(const TRaster& in, const std::vector<double>& filter, Index factor) {
+  const auto origin = Index(filter.size()) / 2;
+  Raster<double, 2> out({(in.length(0) + factor - 1) / factor, (in.length(1) + factor - 1) / factor});
+  for (const auto& p : out.domain()) {
+    double sum = 0;
+    for (Index j = 0; j < Index(filter.size()); ++j) {
+      for (Index i = 0; i < Index(filter.size()); ++i) {
+        const Position<2> q {p[0] * factor + i - origin, p[1] * factor + j - origin};
+        if (in.contains(q)) {
+          sum += filter[i] * filter[j] * in[q];
+        }
+      }
+    }
+    out[p] = sum;
+  }
+  return out;
+}
+
+BOOST_AUTO_TEST_CASE(level_shapes_test) {
+  RasterPyramid<Raster<double>> pyramid(Raster<double>({10, 7}));
+  BOOST_TEST(pyramid.levelCount() == 5);
+  BOOST_TEST(pyramid.shape(1) == Position<2>({5, 4}));
+  BOOST_TEST(pyramid.shape(2) == Position<2>({3, 2}));
+  BOOST_TEST(pyramid.shape(3) == Position<2>({2, 1}));
+  BOOST_TEST(pyramid.shape(4) == Position<2>({1, 1}));
+  BOOST_CHECK_THROW(pyramid.level(5), OutOfBoundsError);
+  BOOST_CHECK_THROW(RasterPyramid<Raster<double>>(Raster<double>({10, 7}), 1), OutOfBoundsError);
+}
+
+BOOST_AUTO_TEST_CASE(binning_test) {
+  Raster<int> base({7, 5});
+  base.range();
+  RasterPyramid<Raster<int>> pyramid(base, 3);
+  BOOST_TEST(not pyramid.isValid(1));
+  const auto& level = pyramid.level(1);
+  BOOST_TEST(pyramid.isValid(1));
+  BOOST_TEST(not pyramid.isValid(2));
+  BOOST_TEST(level.shape() == Position<2>({3, 2}));
+  BOOST_TEST((level[{0, 0}] == (0 + 1 + 2 + 7 + 8 + 9 + 14 + 15 + 16) / 9));
+  BOOST_TEST((level[{2, 1}] == (27 + 34) / 2)); // Partial bin
+}
+
+BOOST_AUTO_TEST_CASE(decimation_test) {
+  Raster<double> base({13, 9});
+  base.generate(UniformNoise<double>(0, 1));
+  const std::vector<double> filter {.1, .2, .4, .2, .1};
+  PtrRaster<const double> view(base.shape(), base.data());
+  RasterPyramid<PtrRaster<const double>> pyramid(view, LineKernel<double>(filter));
+  const auto& level1 = pyramid.level(1);
+  const auto expected1 = bruteForceDecimate(base, filter, 2);
+  BOOST_TEST(level1.shape() == expected1.shape());
+  for (const auto& p : level1.domain()) {
+    BOOST_TEST(level1[p] == expected1[p], boost::test_tools::tolerance(1e-12));
+  }
+  const auto& level2 = pyramid.level(2);
+  const auto expected2 = bruteForceDecimate(expected1, filter, 2);
+  for (const auto& p : level2.domain()) {
+    BOOST_TEST(level2[p] == expected2[p], boost::test_tools::tolerance(1e-12));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(invalidation_test) {
+  Raster<double> base({32, 24});
+  base.generate(UniformNoise<double>(0, 1));
+  const LineKernel<double> filter({.25, .5, .25});
+  RasterPyramid<Raster<double>> pyramid(base, filter);
+  const auto last = pyramid.levelCount() - 1;
+  pyramid.level(last);
+  const Box<2> region {{9, 3}, {12, 4}};
+  for (const auto& p : region) {
+    pyramid.base()[p] = 10;
+  }
+  pyramid.invalidate(region);
+  for (Index i = 1; i <= last; ++i) {
+    BOOST_TEST(not pyramid.isValid(i));
+  }
+  RasterPyramid<Raster<double>> expected(pyramid.base(), filter);
+  for (Index i = 1; i <= last; ++i) {
+    const auto& level = pyramid.level(i);
+    const auto& reference = expected.level(i);
+    for (const auto& p : level.domain()) {
+      BOOST_TEST(level[p] == reference[p], boost::test_tools::tolerance(1e-12));
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -76,6 +76,53 @@ BOOST_AUTO_TEST_CASE(make_sobel_test) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(tiled_4d_test) {
+  const auto sobel = SeparableKernel<int, 0, 1>::sobel();
+  const auto kernel = sobel * LineKernel<int>({1, 2, -3}, 0).along<3>();
+  Raster<int, 4> in({37, 29, 21, 13}); // Several tiles which do not divide the shape
+  in.range(-5000);
+  const auto expected = kernel.compose() * extrapolate(in, 0);
+  Raster<int, 4> out(in.shape());
+  ThreadPool pool(3);
+  kernel.correlateTo(in, out, pool);
+  BOOST_TEST(out == expected);
+  BOOST_TEST(kernel * in == expected);
+}
+
+BOOST_AUTO_TEST_CASE(integer_accumulation_test) {
+  Raster<int, 3> in({40, 40, 40}); // Blocked and remaining lines
+  in.fill(1 << 30);
+  const LineKernel<int> line({1, 1, -1}, 1); // Partial sums overflow 32 bits, and so does the forward-cropped sum
+  const auto check = [&](const auto& kernel, Index axis) {
+    Raster<int, 3> expected(in.shape());
+    line.correlateAlong(in, expected, axis);
+    BOOST_TEST(kernel * in == expected);
+    PositionSampling<3> sampling(Box<3>({0, 0, 0}, {39, 39, 39}), {3, 3, 3});
+    const auto samples = kernel.correlateSamples(in, sampling);
+    for (const auto& q : samples.domain()) {
+      const Position<3> p {q[0] * 3, q[1] * 3, q[2] * 3};
+      BOOST_TEST(samples[q] == expected[p]);
+    }
+  };
+  check(line.along<0>(), 0);
+  check(line.along<1>(), 1);
+  check(line.along<2>(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(samples_test) {
+  const auto kernel = SeparableKernel<int, 0, 1>::sobel() * LineKernel<int>({1, 2, -3}, 0).along<2>();
+  Raster<int, 3> in({17, 13, 7});
+  in.range(-700);
+  const auto expected = kernel * in;
+  const PositionSampling<3> sampling({{0, 1, 2}, {16, 12, 6}}, {3, 5, 2});
+  const auto out = kernel.correlateSamples(in, sampling);
+  BOOST_TEST(out.shape() == Position<3>({6, 3, 3}));
+  for (const auto& q : out.domain()) {
+    const Position<3> p {q[0] * 3, 1 + q[1] * 5, 2 + q[2] * 2};
+    BOOST_TEST(out[q] == expected[p]);
+  }
+}
+
 //-----------------------------------------------------------------------------
 
 BOOST_AUTO_TEST_SUITE_END()
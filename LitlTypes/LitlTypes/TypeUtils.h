@@ -6,7 +6,9 @@
 #define _LITLTYPES_TYPEUTILS_H
 
 #include <complex>
+#include <cstdint> // int64_t, uint64_t
 #include <limits>
+#include <type_traits>
 #include <utility> // forward
 
 namespace Litl {
@@ -104,6 +106,18 @@ struct TypeTraits {
    */
   using Floating = std::conditional_t<std::is_floating_point<T>::value, T, double>;
 
+  /**
+   * @brief The type in which values of type `T` are accumulated.
+   * @details
+   * A type wide enough to sum many values of type `T` without overflow or significant precision loss:
+   * a 64-bit integer type of the same signedness for integers, and at least `double` for floating points.
+   * Can be complex.
+   */
+  using Accumulator = std::conditional_t<
+      std::is_integral<T>::value,
+      std::conditional_t<std::is_signed<T>::value, std::int64_t, std::uint64_t>,
+      std::common_type_t<T, double>>;
+
   /**
    * @brief The scalar type which corresponds to `T`.
    * @details
@@ -111,6 +125,18 @@ struct TypeTraits {
    */
   using Scalar = T;
 
+  /**
+   * @brief Get a code which identifies the binary representation of `T` across processes.
+   * @details
+   * The code is made of the kind of type (unsigned or signed integer, floating point, complex or other)
+   * and of its size.
+   */
+  static constexpr std::uint32_t code() {
+    const std::uint32_t kind =
+        std::is_integral<T>::value ? (std::is_signed<T>::value ? 2 : 1) : std::is_floating_point<T>::value ? 3 : 0;
+    return (kind << 16) | std::uint32_t(sizeof(T));
+  }
+
   /**
    * @brief Make some `T` from a scalar.
    * @details
@@ -138,8 +164,14 @@ struct TypeTraits<std::complex<T>> {
 
   using Floating = std::complex<T>;
 
+  using Accumulator = std::complex<typename TypeTraits<T>::Accumulator>;
+
   using Scalar = T;
 
+  static constexpr std::uint32_t code() {
+    return (4 << 16) | std::uint32_t(sizeof(std::complex<T>));
+  }
+
   static inline std::complex<T> fromScalar(T in) {
     return {in, in};
   }
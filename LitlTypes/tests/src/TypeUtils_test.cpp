@@ -17,10 +17,14 @@ BOOST_AUTO_TEST_SUITE(TypeUtils_test)
 template <typename T>
 void checkTypeTraits(T) {
   using Floating = typename TypeTraits<T>::Floating;
+  using Accumulator = typename TypeTraits<T>::Accumulator;
   using Scalar = typename TypeTraits<T>::Scalar;
   BOOST_TEST(std::is_floating_point<Floating>::value);
   BOOST_TEST(Limits<Floating>::min() <= Limits<T>::min());
   BOOST_TEST(Limits<Floating>::max() >= Limits<T>::max());
+  BOOST_TEST(sizeof(Accumulator) >= sizeof(T));
+  BOOST_TEST(sizeof(Accumulator) >= sizeof(double));
+  BOOST_TEST(std::is_signed<Accumulator>::value == std::is_signed<T>::value);
   BOOST_TEST(std::is_scalar<Scalar>::value);
 }
 
@@ -35,6 +39,13 @@ LITL_TEST_CASE_TEMPLATE(type_traits_test) {
   checkTypeTraits(T());
 }
 
+BOOST_AUTO_TEST_CASE(type_code_test) {
+  BOOST_TEST(TypeTraits<std::int32_t>::code() != TypeTraits<std::uint32_t>::code());
+  BOOST_TEST(TypeTraits<std::int32_t>::code() != TypeTraits<float>::code());
+  BOOST_TEST(TypeTraits<std::int64_t>::code() != TypeTraits<std::int32_t>::code());
+  BOOST_TEST(TypeTraits<std::complex<float>>::code() != TypeTraits<double>::code());
+}
+
 //-----------------------------------------------------------------------------
 
 BOOST_AUTO_TEST_SUITE_END()